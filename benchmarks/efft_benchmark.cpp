@@ -1,7 +1,20 @@
 #include "efft.hpp"
 #include <benchmark/benchmark.h>
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 template <unsigned int N>
 class RandEventGenerator {
@@ -80,12 +93,281 @@ static void BenchmarkFeedWithEvents(benchmark::State &state) {
       [[maybe_unused]] auto result = efft.getFFT();
     }
   }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
 }
 BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 16);
 BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 32);
 BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 64);
 BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 128);
 BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEvents, 1024);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithEventsHalfSpectrum(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<FRAME_SIZE, FRAME_SIZE, eFFTHalfSpectrumTraits> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsHalfSpectrum, 128);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsHalfSpectrum, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsHalfSpectrum, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsHalfSpectrum, 1024);
+
+template <unsigned int B>
+struct BlockTraits : eFFTTraits {
+  static constexpr unsigned int LEAF_BLOCK = B;
+};
+
+template <unsigned int FRAME_SIZE, unsigned int B>
+static void BenchmarkFeedWithEventsBlocked(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<FRAME_SIZE, FRAME_SIZE, BlockTraits<B>> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 16, 4);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 16, 8);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 64, 4);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 64, 8);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 256, 4);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsBlocked, 256, 8);
+
+template <unsigned int FRAME_SIZE, unsigned int B>
+static void BenchmarkFeedWithPacketsBlocked(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<FRAME_SIZE, FRAME_SIZE, BlockTraits<B>> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = rand.next(state.range(0));
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsBlocked, 128, 4)->Arg(100)->Arg(1000)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsBlocked, 128, 8)->Arg(100)->Arg(1000)->Arg(5000);
+
+struct Radix4Traits : eFFTTraits {
+  static constexpr unsigned int RADIX = 4;
+};
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithEventsRadix4(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<FRAME_SIZE, FRAME_SIZE, Radix4Traits> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 16);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 32);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 64);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 128);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRadix4, 1024);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithPacketsRadix4(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<FRAME_SIZE, FRAME_SIZE, Radix4Traits> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = rand.next(state.range(0));
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsRadix4, 128)->Arg(100)->Arg(500)->Arg(1000)->Arg(2500)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsRadix4, 256)->Arg(100)->Arg(500)->Arg(1000)->Arg(2500)->Arg(5000);
+
+template <unsigned int WIDTH, unsigned int HEIGHT>
+static void BenchmarkFeedWithEventsRectangular(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<WIDTH, HEIGHT> efft;
+  efft.initialize();
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      const Stimulus c = cols.next();
+      efft.update(Stimulus(rows.next().row, c.col, c.state));
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRectangular, 512, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRectangular, 512, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRectangular, 1024, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsRectangular, 1024, 1024);
+
+template <unsigned int WIDTH, unsigned int HEIGHT>
+static void BenchmarkFeedWithPacketsRectangular(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<WIDTH, HEIGHT> efft;
+  efft.initialize();
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = cols.next(state.range(0));
+      for(Stimulus &s : ss) {
+        s.row = rows.next().row;
+      }
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsRectangular, 512, 256)->Arg(1000)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsRectangular, 512, 512)->Arg(1000)->Arg(5000);
+
+template <typename S, unsigned int COMPACT = 0, typename C = bfloat16>
+struct PrecisionTraits : eFFTTraits {
+  using Scalar = S;
+  using Compact = C;
+  static constexpr unsigned int COMPACT_LEVELS = COMPACT;
+};
+
+template <unsigned int FRAME_SIZE, typename Traits>
+static void BenchmarkFeedWithPacketsPrecision(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = rand.next(state.range(0));
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+
+  efft.initialize();
+  efft.initializeGroundTruth();
+  ss = rand.next(FRAME_SIZE * FRAME_SIZE / 4);
+  efft.update(ss);
+  efft.updateGroundTruth(ss);
+  state.counters["error"] = efft.check() / (FRAME_SIZE * FRAME_SIZE); // relative to N²
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 256, PrecisionTraits<float>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 256, PrecisionTraits<double>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 256, PrecisionTraits<float, 6, bfloat16>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 256, PrecisionTraits<float, 6, float16>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 1024, PrecisionTraits<float>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 1024, PrecisionTraits<double>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 1024, PrecisionTraits<float, 6, bfloat16>)->Arg(1000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsPrecision, 1024, PrecisionTraits<float, 8, float16>)->Arg(1000);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithEventsDelta(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<FRAME_SIZE> efft;
+  efft.setPropagation(Propagation::Delta);
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 16);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 32);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 64);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 128);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 512);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsDelta, 1024);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithEventsLazy(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 5000;
+  const std::size_t events_per_read = state.range(0);
+  eFFT<FRAME_SIZE> efft;
+  efft.setLazy(true);
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 1; it <= num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      if(it % events_per_read == 0) {
+        [[maybe_unused]] auto result = efft.getFFT();
+      }
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsLazy, 128)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsLazy, 256)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000);
 
 template <unsigned int FRAME_SIZE>
 static void BenchmarkFeedWithPackets(benchmark::State &state) {
@@ -103,8 +385,413 @@ static void BenchmarkFeedWithPackets(benchmark::State &state) {
       [[maybe_unused]] auto result = efft.getFFT();
     }
   }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
 }
 BENCHMARK_TEMPLATE(BenchmarkFeedWithPackets, 128)->Arg(100)->Arg(500)->Arg(1000)->Arg(2500)->Arg(5000);
 BENCHMARK_TEMPLATE(BenchmarkFeedWithPackets, 256)->Arg(100)->Arg(500)->Arg(1000)->Arg(2500)->Arg(5000);
 
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithPacketsDeduplicated(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<FRAME_SIZE> efft;
+  efft.setDeduplicate(true);
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = rand.next(state.range(0));
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsDeduplicated, 128)->Arg(100)->Arg(1000)->Arg(5000)->Arg(10000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsDeduplicated, 256)->Arg(100)->Arg(1000)->Arg(5000)->Arg(10000);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFilter(benchmark::State &state) {
+  RandEventGenerator<FRAME_SIZE> rand;
+  const Stimuli packet = rand.next(static_cast<unsigned int>(state.range(0)));
+
+  Stimuli ss;
+  for(auto _ : state) {
+    ss = packet;
+    if(state.range(1) != 0) {
+      ss.filter(FRAME_SIZE);
+    } else {
+      ss.filter();
+    }
+    benchmark::DoNotOptimize(ss.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFilter, 128)->ArgNames({"events", "dense"})->ArgsProduct({{1000, 10000}, {0, 1}});
+BENCHMARK_TEMPLATE(BenchmarkFilter, 256)->ArgNames({"events", "dense"})->ArgsProduct({{1000, 10000}, {0, 1}});
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithRedundantEvents(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 250;
+  eFFT<FRAME_SIZE> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss = rand.next(num_events_to_process);
+  ss.on();
+  efft.update(ss);
+  for(auto _ : state) {
+    for(const Stimulus &s : ss) {
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithRedundantEvents, 256);
+BENCHMARK_TEMPLATE(BenchmarkFeedWithRedundantEvents, 1024);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkConstruction(benchmark::State &state) {
+  std::size_t footprint = 0;
+  for(auto _ : state) {
+    eFFT<FRAME_SIZE> efft;
+    footprint = efft.footprint();
+    benchmark::DoNotOptimize(efft);
+  }
+  state.counters["footprint"] = static_cast<double>(footprint);
+  state.counters["shared"] = static_cast<double>(eFFT<FRAME_SIZE>::sharedFootprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 16);
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 64);
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 128);
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 256);
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 512);
+BENCHMARK_TEMPLATE(BenchmarkConstruction, 1024);
+
+#ifdef __linux__
+static std::size_t ResidentBytes() {
+#ifdef __GLIBC__
+  malloc_trim(0); // return the freed heap pages so that they are not reused unaccounted
+#endif
+  std::ifstream statm("/proc/self/statm");
+  std::size_t pages = 0;
+  std::size_t resident = 0;
+  statm >> pages >> resident;
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkConstructionTiled(benchmark::State &state) {
+  const auto tiles = static_cast<std::size_t>(state.range(0));
+  const std::size_t before = ResidentBytes();
+  const std::vector<eFFT<FRAME_SIZE>> resident(tiles);
+  const std::size_t after = ResidentBytes();
+  for(auto _ : state) {
+    std::vector<eFFT<FRAME_SIZE>> efft(tiles);
+    benchmark::DoNotOptimize(efft.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tiles));
+  state.counters["rss_per_instance"] = static_cast<double>(after - before) / static_cast<double>(tiles);
+}
+BENCHMARK_TEMPLATE(BenchmarkConstructionTiled, 16)->Arg(64);
+BENCHMARK_TEMPLATE(BenchmarkConstructionTiled, 32)->Arg(64);
+BENCHMARK_TEMPLATE(BenchmarkConstructionTiled, 64)->Arg(64);
+#endif
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkReset(benchmark::State &state) {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  Stimuli ss = rand.next(static_cast<unsigned int>(state.range(0)));
+  ss.on();
+
+  for(auto _ : state) {
+    state.PauseTiming();
+    efft.update(ss);
+    state.ResumeTiming();
+    if(state.range(1) != 0) {
+      efft.reset();
+    } else {
+      efft.initialize();
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BenchmarkReset, 256)->ArgNames({"events", "reset"})->ArgsProduct({{100, 10000}, {0, 1}});
+BENCHMARK_TEMPLATE(BenchmarkReset, 1024)->ArgNames({"events", "reset"})->ArgsProduct({{100, 10000}, {0, 1}});
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkInitializeWithImage(benchmark::State &state) {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  cfloatmat image(cfloatmat::Zero(FRAME_SIZE, FRAME_SIZE));
+  for(const Stimulus &s : rand.next(FRAME_SIZE * FRAME_SIZE / 4)) {
+    image(s.row, s.col) = 1;
+  }
+
+  for(auto _ : state) {
+    efft.initialize(image);
+    benchmark::DoNotOptimize(efft.getFFT().data());
+  }
+}
+BENCHMARK_TEMPLATE(BenchmarkInitializeWithImage, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BenchmarkInitializeWithImage, 512)->Unit(benchmark::kMillisecond);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkSnapshot(benchmark::State &state) {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.update(rand.next(FRAME_SIZE * FRAME_SIZE / 4));
+  const std::string path = (std::filesystem::temp_directory_path() / "efft_benchmark.snapshot").string();
+  efft.save(path);
+
+  for(auto _ : state) {
+    if(state.range(0) != 0) {
+      efft.load(path);
+    } else {
+      efft.save(path);
+    }
+  }
+  std::filesystem::remove(path);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * efft.snapshotSize()));
+}
+BENCHMARK_TEMPLATE(BenchmarkSnapshot, 256)->ArgName("load")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BenchmarkSnapshot, 512)->ArgName("load")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkReadout(benchmark::State &state) {
+  constexpr unsigned int band = 32;
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.update(rand.next(FRAME_SIZE * FRAME_SIZE / 4));
+  Eigen::Matrix<cfloat, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> full;
+  std::vector<cfloat> out(band * band);
+
+  for(auto _ : state) {
+    switch(state.range(0)) {
+    case 0: // full row-major copy, as the Python get_fft()
+      full = efft.getFFT();
+      benchmark::DoNotOptimize(full.data());
+      break;
+    case 1: // low-frequency band into a caller buffer
+      efft.copyTo(out.data(), 0, 0, band, band);
+      benchmark::DoNotOptimize(out.data());
+      break;
+    default: // single bin
+      benchmark::DoNotOptimize(efft.bin(1, 1));
+      break;
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BenchmarkReadout, 512)->ArgName("mode")->Arg(0)->Arg(1)->Arg(2);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeatures(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 10000;
+  const std::vector<double> edges{0.0, 0.1, 0.2, 0.3, 0.5};
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  const bool fused = state.range(1) == 1;
+  eFFT<FRAME_SIZE> efft;
+  efft.initialize();
+  efft.setFeatures(fused, edges);
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  // the consumer's own pass: power map, then one masked sum per band
+  using RealMatrix = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic>;
+  RealMatrix power(FRAME_SIZE, FRAME_SIZE);
+  std::vector<RealMatrix> masks(edges.size() - 1, RealMatrix::Zero(FRAME_SIZE, FRAME_SIZE));
+  for(unsigned int u = 0; u < FRAME_SIZE; u++) {
+    for(unsigned int v = 0; v < FRAME_SIZE; v++) {
+      const double fu = static_cast<double>(std::min(u, FRAME_SIZE - u)) / FRAME_SIZE;
+      const double fv = static_cast<double>(std::min(v, FRAME_SIZE - v)) / FRAME_SIZE;
+      const auto k = std::upper_bound(edges.begin(), edges.end(), std::sqrt(fu * fu + fv * fv)) - edges.begin() - 1;
+      if(k >= 0 && k < static_cast<int>(masks.size())) {
+        masks[k](u, v) = 1;
+      }
+    }
+  }
+
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      efft.update(rand.next(state.range(0)));
+      if(fused) {
+        benchmark::DoNotOptimize(efft.getPower().data());
+        for(std::size_t b = 0; b < efft.bands(); b++) {
+          benchmark::DoNotOptimize(efft.bandEnergy(b));
+        }
+        benchmark::DoNotOptimize(efft.totalEnergy());
+      } else {
+        power = efft.getFFT().cwiseAbs2();
+        for(const RealMatrix &mask : masks) {
+          benchmark::DoNotOptimize(power.cwiseProduct(mask).sum());
+        }
+        benchmark::DoNotOptimize(power.sum());
+      }
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeatures, 256)->ArgNames({"events", "fused"})->ArgsProduct({{10, 1000}, {0, 1}});
+BENCHMARK_TEMPLATE(BenchmarkFeatures, 1024)->ArgNames({"events", "fused"})->ArgsProduct({{10, 1000}, {0, 1}});
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithPacketsParallel(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  constexpr std::size_t packet_size = 5000;
+  constexpr std::size_t num_iterations = num_events_to_process / packet_size;
+  eFFT<FRAME_SIZE> efft;
+  efft.setThreads(static_cast<unsigned int>(state.range(0)));
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimuli ss;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      ss = rand.next(packet_size);
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithPacketsParallel, 256)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWithEventsParallel(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 50;
+  eFFT<FRAME_SIZE> efft;
+  efft.setThreads(static_cast<unsigned int>(state.range(0)));
+  efft.setParallelCombine(256);
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  Stimulus s;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_events_to_process; it++) {
+      s = rand.next();
+      efft.update(s);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_events_to_process));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsParallel, 512)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BenchmarkFeedWithEventsParallel, 1024)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedPipelined(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 100000;
+  constexpr std::size_t packet_size = 100;
+  const bool pipelined = state.range(0) == 1;
+  eFFT<FRAME_SIZE> efft;
+  efft.initialize();
+  eFFTPipeline<FRAME_SIZE> pipeline(num_events_to_process); // holds a whole burst
+  RandEventGenerator<FRAME_SIZE> rand;
+  const Stimuli ss = rand.next(num_events_to_process);
+
+  double producer = 0;
+  for(auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t first = 0; first < ss.size(); first += packet_size) {
+      if(pipelined) {
+        for(std::size_t queued = 0; queued < packet_size;) { // the driver would drop instead of retrying
+          queued += pipeline.push(ss.data() + first + queued, packet_size - queued);
+        }
+      } else {
+        efft.update(ss.data() + first, packet_size);
+      }
+    }
+    producer += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    pipeline.drain();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ss.size()));
+  state.counters["producer_ns"] = producer / static_cast<double>(state.iterations() * ss.size()); // producer time per event
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedPipelined, 256)->ArgName("pipelined")->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK_TEMPLATE(BenchmarkFeedPipelined, 512)->ArgName("pipelined")->Arg(0)->Arg(1)->UseRealTime();
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWindowed(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  constexpr uint64_t packet_duration = 1000;
+  constexpr uint64_t window_packets = 10;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFTWindow<FRAME_SIZE> efft(window_packets * packet_duration);
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  uint64_t t = 0;
+  TimedStimuli ss(state.range(0));
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      const Stimuli packet = rand.next(state.range(0));
+      for(std::size_t k = 0; k < ss.size(); k++) {
+        ss[k] = TimedStimulus(packet[k].row, packet[k].col, t + k * packet_duration / ss.size());
+      }
+      t += packet_duration;
+      efft.update(ss);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+  state.counters["footprint"] = static_cast<double>(efft.footprint());
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWindowed, 256)->Arg(1000)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWindowed, 1024)->Arg(1000)->Arg(5000);
+
+template <unsigned int FRAME_SIZE>
+static void BenchmarkFeedWindowedManually(benchmark::State &state) {
+  constexpr std::size_t num_events_to_process = 500000;
+  constexpr std::size_t window_packets = 10;
+  const std::size_t num_iterations = num_events_to_process / state.range(0);
+  eFFT<FRAME_SIZE> efft;
+  efft.initialize();
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  std::deque<Stimuli> window;
+  for(auto _ : state) {
+    for(std::size_t it = 0; it < num_iterations; it++) {
+      window.push_back(rand.next(state.range(0)));
+      window.back().on();
+      if(window.size() > window_packets) {
+        window.front().off();
+        efft.update(window.front());
+        window.pop_front();
+      }
+      efft.update(window.back());
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_iterations * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BenchmarkFeedWindowedManually, 256)->Arg(1000)->Arg(5000);
+BENCHMARK_TEMPLATE(BenchmarkFeedWindowedManually, 1024)->Arg(1000)->Arg(5000);
+
+template <Butterfly::Kernel KERNEL>
+static void BenchmarkButterfly(benchmark::State &state) {
+  const auto n = static_cast<unsigned int>(state.range(0));
+  std::vector<cfloat> x(static_cast<std::size_t>(n) * n);
+  std::vector<cfloat> children(static_cast<std::size_t>(n) * n, cfloat{0.5F, -0.25F});
+  std::vector<cfloat> w(n);
+  for(unsigned int k = 0; k < n; k++) {
+    w[k] = std::polar(1.0F, -2.0F * 3.14159265358979323846F * static_cast<float>(k) / static_cast<float>(n));
+  }
+
+  for(auto _ : state) {
+    KERNEL(x.data(), children.data(), w.data(), w.data(), n, n, 0, n >> 1U);
+    benchmark::DoNotOptimize(x.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (n >> 1U) * (n >> 1U)));
+}
+BENCHMARK_TEMPLATE(BenchmarkButterfly, Butterfly::scalar)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+BENCHMARK_TEMPLATE(BenchmarkButterfly, Butterfly::avx2)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+#endif
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+BENCHMARK_TEMPLATE(BenchmarkButterfly, Butterfly::avx512)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+#endif
+
 BENCHMARK_MAIN();
@@ -0,0 +1,109 @@
+#include "efft.hpp"
+#include "efft_reader.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+
+// Replays an event file through eFFT and reports the throughput from disk, decoding only and decoding plus update().
+//   efft-replay [FILE FORMAT] [-n EVENTS_PER_PACKET | -t MICROSECONDS_PER_PACKET]
+// FORMAT is packed, evt2, evt3 or aedat2. Without a file, a synthetic 640x480 recording is generated.
+
+struct Options {
+  std::string path;
+  EventFormat format{EventFormat::Packed};
+  std::size_t count{1000};
+  uint64_t duration{0};
+};
+
+template <typename Packet>
+static bool next(EventReader &reader, Packet &packet, const Options &options) {
+  return options.duration > 0 ? reader.readFor(packet, options.duration) : reader.read(packet, options.count);
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT>
+static void replay(EventReader &reader, const Options &options) {
+  using clock = std::chrono::steady_clock;
+  Stimuli packet;
+  reader.setFrame(WIDTH, HEIGHT);
+
+  std::size_t events = 0;
+  std::size_t packets = 0;
+  auto start = clock::now();
+  while(next(reader, packet, options)) {
+    events += packet.size();
+    packets++;
+  }
+  const double decode = std::chrono::duration<double>(clock::now() - start).count();
+
+  eFFT<WIDTH, HEIGHT> efft;
+  efft.initialize();
+  reader.rewind();
+  start = clock::now();
+  while(next(reader, packet, options)) {
+    efft.update(packet);
+  }
+  const double total = std::chrono::duration<double>(clock::now() - start).count();
+
+  std::printf("frame      %ux%u\n", WIDTH, HEIGHT);
+  std::printf("events     %zu in %zu packets (%zu bytes)\n", events, packets, reader.offset());
+  std::printf("decode     %.3f s, %.2f Mev/s\n", decode, static_cast<double>(events) / decode * 1e-6);
+  std::printf("replay     %.3f s, %.2f Mev/s\n", total, static_cast<double>(events) / total * 1e-6);
+}
+
+static std::string synthesize() {
+  constexpr unsigned int WIDTH = 640;
+  constexpr unsigned int HEIGHT = 480;
+  std::mt19937 gen(42);
+  TimedStimuli events(2000000);
+  uint64_t t = 0;
+  for(TimedStimulus &e : events) {
+    t += gen() % 4;
+    e = TimedStimulus(gen() % HEIGHT, gen() % WIDTH, t, gen() % 2 == 0);
+  }
+  const std::string path = (std::filesystem::temp_directory_path() / "efft_replay.bin").string();
+  writePackedEvents(path, events.data(), events.size(), WIDTH, HEIGHT);
+  return path;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for(int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if(arg == "-n" && i + 1 < argc) {
+      options.count = std::strtoull(argv[++i], nullptr, 10);
+    } else if(arg == "-t" && i + 1 < argc) {
+      options.duration = std::strtoull(argv[++i], nullptr, 10);
+    } else if(options.path.empty()) {
+      options.path = arg;
+    } else if(arg == "packed" || arg == "evt2" || arg == "evt3" || arg == "aedat2") {
+      options.format = arg == "packed" ? EventFormat::Packed : arg == "evt2" ? EventFormat::EVT2 : arg == "evt3" ? EventFormat::EVT3 : EventFormat::AEDAT2;
+    } else {
+      std::fprintf(stderr, "usage: %s [FILE packed|evt2|evt3|aedat2] [-n EVENTS | -t MICROSECONDS]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  const bool synthetic = options.path.empty();
+  if(synthetic) {
+    options.path = synthesize();
+  }
+
+  EventReader reader;
+  if(!reader.open(options.path, options.format)) {
+    std::fprintf(stderr, "cannot read %s\n", options.path.c_str());
+    return EXIT_FAILURE;
+  }
+  if(reader.width() <= 1024 && reader.height() <= 512) {
+    replay<1024, 512>(reader, options);
+  } else {
+    replay<2048, 1024>(reader, options); // larger sensors, e.g. 1280x720, cropped beyond 2048x1024
+  }
+  reader.close();
+
+  if(synthetic) {
+    std::filesystem::remove(options.path);
+  }
+  return EXIT_SUCCESS;
+}
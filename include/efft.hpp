@@ -12,12 +12,25 @@
 #include <Eigen/Core>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <complex>
+#include <condition_variable>
 #include <cstddef>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
 #include <new>
 #include <ostream>
 #include <stdint.h>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -27,6 +40,14 @@
 #include <set>
 #endif
 
+#ifdef EFFT_USE_HUGE_PAGES
+#include <sys/mman.h>
+#endif
+
+#if !defined(EFFT_DISABLE_SIMD) && (defined(__AVX2__) && defined(__FMA__) || defined(__AVX512F__) || defined(__F16C__))
+#include <immintrin.h>
+#endif
+
 #if EIGEN_MAJOR_VERSION >= 5
 #define EIGEN_LAST Eigen::placeholders::last
 #else
@@ -65,6 +86,70 @@ public:
   }
 };
 
+/**
+ * @brief Stimulus with a timestamp, for time-windowed transforms (see eFFTWindow).
+ */
+class TimedStimulus : public Stimulus {
+public:
+  uint64_t t{0}; ///< Timestamp in microseconds.
+  TimedStimulus() = default;
+  TimedStimulus(const unsigned int row, const unsigned int col, const uint64_t t) : Stimulus(row, col), t{t} {};
+  TimedStimulus(const unsigned int row, const unsigned int col, const uint64_t t, const bool state) : Stimulus(row, col, state), t{t} {};
+  friend std::ostream &operator<<(std::ostream &os, const TimedStimulus &stimulus) {
+    os << "TimedStimulus(row: " << stimulus.row << ", col: " << stimulus.col << ", t: " << stimulus.t << ", state: " << (stimulus.state ? "on" : "off") << ")";
+    return os;
+  }
+};
+
+using TimedStimuli = std::vector<TimedStimulus>;
+
+/**
+ * @brief Dense pixel-to-slot table that is cleared in constant time.
+ *
+ * Every entry carries the generation it was written in, so starting a new pass only bumps the generation. The table
+ * only allocates when it grows.
+ */
+class PixelTable {
+public:
+  /**
+   * @brief Starts a new pass over a frame.
+   *
+   * @param pixels Number of pixels of the frame.
+   */
+  void reset(const std::size_t pixels) {
+    if(stamps_.size() < pixels) {
+      stamps_.assign(pixels, 0);
+      slots_.resize(pixels);
+      generation_ = 0;
+    }
+    if(++generation_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      generation_ = 1;
+    }
+  }
+
+  /**
+   * @brief Looks up a pixel, inserting it if it was not seen in this pass.
+   *
+   * @param pixel Pixel index.
+   * @param slot Slot to store if the pixel is new.
+   * @return The slot of the pixel and whether it was inserted.
+   */
+  std::pair<uint32_t, bool> emplace(const std::size_t pixel, const uint32_t slot) {
+    if(stamps_[pixel] == generation_) {
+      return {slots_[pixel], false};
+    }
+    stamps_[pixel] = generation_;
+    slots_[pixel] = slot;
+    return {slot, true};
+  }
+
+private:
+  std::vector<uint32_t> stamps_;
+  std::vector<uint32_t> slots_;
+  uint32_t generation_{0};
+};
+
 class Stimuli : public std::vector<Stimulus> {
   using std::vector<Stimulus>::vector;
 
@@ -110,6 +195,35 @@ public:
     }
     this->assign(out.begin(), out.end());
   }
+
+  /**
+   * @brief Filters out repeated stimuli of a frame of known size.
+   *
+   * Same result as filter(), but computed in place with a dense table that is reused across calls, so it runs in a
+   * single linear pass and does not allocate in the steady state.
+   *
+   * @note Coordinates outside the frame wrap around (only their low bits are used), as in eFFT, so stimuli that land on
+   * the same pixel of the frame are treated as repeated.
+   *
+   * @param framesize Frame size, a power of two.
+   */
+  void filter(const unsigned int framesize) {
+    thread_local PixelTable table;
+    table.reset(static_cast<std::size_t>(framesize) * framesize);
+
+    const unsigned int mask = framesize - 1;
+    std::size_t count = 0;
+    for(std::size_t i = 0; i < size(); i++) {
+      const Stimulus s = (*this)[i];
+      const auto [slot, inserted] = table.emplace(static_cast<std::size_t>(s.row & mask) * framesize + (s.col & mask), static_cast<uint32_t>(count));
+      if(inserted) {
+        (*this)[count++] = s;
+      } else if(s.state) {
+        (*this)[slot].state = true; // prefer state true over false
+      }
+    }
+    resize(count);
+  }
 };
 
 using cfloat = std::complex<float>;
@@ -122,360 +236,3275 @@ constexpr unsigned int LOG2(const unsigned int n) { return ((n < 2) ? 0 : 1 + LO
 #define EFFT_HAS_BUILTIN_FFS
 #endif
 #endif
+#ifdef __has_builtin
+#if __has_builtin(__builtin_ctzll)
+#define EFFT_HAS_BUILTIN_CTZ
+#endif
+#endif
 #ifdef EFFT_HAS_BUILTIN_FFS
 inline unsigned int log2i(const unsigned int n) { return __builtin_ffs(static_cast<int>(n)) - 1; }
 #else
 inline unsigned int log2i(const unsigned int n) { return static_cast<unsigned int>(std::log2f(n)); }
 #endif
-
-template <unsigned int N>
-class eFFT {
-private:
-  static constexpr unsigned int LOG2_N = LOG2(N);
-  std::array<std::vector<cfloatmat>, LOG2_N + 1> tree_;
-  std::vector<cfloat> twiddle_;
-#ifdef EFFT_USE_FFTW3
-  fftw_complex *fftwInput_{nullptr};
-  fftw_complex *fftwOutput_{nullptr};
-  fftw_plan plan_{nullptr};
+#ifdef EFFT_HAS_BUILTIN_CTZ
+inline unsigned int ctz64(const uint64_t n) { return static_cast<unsigned int>(__builtin_ctzll(n)); }
+#else
+inline unsigned int ctz64(uint64_t n) {
+  unsigned int k = 0;
+  for(; (n & 1U) == 0; n >>= 1U) {
+    k++;
+  }
+  return k;
+}
 #endif
 
-public:
-  eFFT() {
-    constexpr float PI = 3.14159265358979323846F;
-    constexpr float MINUS_TWO_PI = -2 * PI;
-    twiddle_.resize(static_cast<std::size_t>(N) * static_cast<std::size_t>(N + 1));
-#ifdef EFFT_USE_FFTW3
-    fftwInput_ = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * static_cast<std::size_t>(N) * static_cast<std::size_t>(N)));
-    fftwOutput_ = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * static_cast<std::size_t>(N) * static_cast<std::size_t>(N)));
-    if(!fftwInput_ || !fftwOutput_) throw std::bad_alloc();
-#endif
-    for(unsigned int i = 0; i < N; i++) {
-      twiddle_[i] = cfloat{1.0F, 0.0F};
-      for(unsigned int n = 1; n <= N; n++) {
-        twiddle_[i + N * n] = static_cast<cfloat>(std::polar(1.0F, MINUS_TWO_PI * static_cast<float>(i) / static_cast<float>(n)));
-      }
+/**
+ * @brief Radix-2x2 butterfly kernels shared by initialize() and both update() paths.
+ *
+ * A kernel recombines the columns [j0, j1) of an n x m node (n rows, m columns, column-major) from its four
+ * (n/2) x (m/2) children x00, x01, x10 and x11, which are stored contiguously starting at x00. The twiddle factors are
+ * read as wr[k] = exp(-2πik/n) along the rows and wc[k] = exp(-2πik/m) along the columns; square nodes pass the same
+ * table twice and read the diagonal twiddle wr[i + j] directly, rectangular ones multiply wr[i] by wc[j]. Data is
+ * interleaved (std::complex) and the SIMD kernels vectorize the inner loop over rows with FMA complex multiplications.
+ * The widest kernel enabled at compile time is used, unless EFFT_DISABLE_SIMD is defined.
+ *
+ * The *Half kernels work on half spectra: an n x m node only stores its columns 0..m/2, which determine the rest by
+ * conjugate symmetry when the input is real. Every stored child column j <= m/4 yields output column j directly and
+ * output column j + m/2 through the second half of the butterfly, which is stored mirrored as column m/2 - j.
+ *
+ * The line kernels recombine a node of n elements from its two halves, for the levels of rectangular frames that only
+ * split the longer axis.
+ */
+struct Butterfly {
+  using Kernel = void (*)(cfloat *, const cfloat *, const cfloat *, const cfloat *, unsigned int, unsigned int, unsigned int, unsigned int);
+
+  template <typename T>
+  static inline void scalar(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    for(unsigned int j = j0; j < j1; j++) {
+      column(x, x00, wr, wc, n, m, j, 0);
     }
   }
 
-  ~eFFT() {
-#ifdef EFFT_USE_FFTW3
-    if(plan_) fftw_destroy_plan(plan_);
-    if(fftwInput_) fftw_free(fftwInput_);
-    if(fftwOutput_) fftw_free(fftwOutput_);
-#endif
+  template <typename T>
+  static inline void scalarHalf(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    for(unsigned int j = j0; j < j1; j++) {
+      halfColumn(x, x00, wr, wc, n, m, j, 0, n >> 1U);
+    }
   }
 
-  eFFT(const eFFT &) = delete;
-  eFFT(eFFT &&) noexcept = default;
-  eFFT &operator=(const eFFT &) = delete;
-  eFFT &operator=(eFFT &&) noexcept = default;
-
   /**
-   * @brief Get the frame size of the FFT.
-   * @return The frame size as an unsigned integer.
+   * @brief Recombine the elements j and j + n/2 of a line, for j in [j0, j1) and j1 <= n/2.
    */
-  [[nodiscard]] constexpr unsigned int framesize() const {
-    return N;
+  template <typename T>
+  static inline void line(T *x, const T *x0, const T *w, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U;
+    const T *x1 = x0 + ndiv2;
+    for(unsigned int j = j0; j < j1; j++) {
+      const T t = w[j] * x1[j];
+      x[j] = x0[j] + t;
+      x[j + ndiv2] = x0[j] - t;
+    }
   }
 
   /**
-   * @brief Initializes the FFT computation with zero matrix.
+   * @brief Recombine the elements 0..n/2 of a half-spectrum line from the children elements [j0, j1), with j1 <= n/4 + 1.
    */
-  void initialize() {
-    cfloatmat f0(cfloatmat::Zero(N, N));
-    initialize(f0);
+  template <typename T>
+  static inline void lineHalf(T *x, const T *x0, const T *w, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U;
+    const T *x1 = x0 + (ndiv2 >> 1U) + 1;
+    for(unsigned int j = j0; j < j1; j++) {
+      const T t = w[j] * x1[j];
+      x[j] = x0[j] + t;
+      if(j == 0) {
+        x[ndiv2] = x0[j] - t;
+      } else if(2 * j < ndiv2) {
+        x[ndiv2 - j] = std::conj(x0[j] - t);
+      }
+    }
   }
 
-  /**
-   * @brief Initializes the FFT computation with the provided matrix.
-   *
-   * @param x Input matrix.
-   * @param offset Offset for the tree structure.
-   */
-  void initialize(cfloatmat &x, const int offset = 0) {
-    const unsigned int n = x.rows();
-    if(n == 1) {
-      tree_[0].emplace_back(x);
-      return;
-    }
-    const unsigned int ndiv2 = n >> 1U;
-    const unsigned int idx = log2i(ndiv2);
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline void avx2(cfloat *x, const cfloat *x00, const cfloat *wr, const cfloat *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const unsigned int nmdiv2 = n * mdiv2;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * mdiv2;
+    const bool square = n == m;
+    const float *f00 = reinterpret_cast<const float *>(x00);
+    const float *f01 = reinterpret_cast<const float *>(x00 + q);
+    const float *f10 = reinterpret_cast<const float *>(x00 + 2 * q);
+    const float *f11 = reinterpret_cast<const float *>(x00 + 3 * q);
+    const float *fw = reinterpret_cast<const float *>(wr);
+    float *fx = reinterpret_cast<float *>(x);
 
-    cfloatmat s00(x(Eigen::seq(Eigen::fix<0>, EIGEN_LAST, Eigen::fix<2>), Eigen::seq(Eigen::fix<0>, EIGEN_LAST, Eigen::fix<2>)));
-    cfloatmat s01(x(Eigen::seq(Eigen::fix<0>, EIGEN_LAST, Eigen::fix<2>), Eigen::seq(Eigen::fix<1>, EIGEN_LAST, Eigen::fix<2>)));
-    cfloatmat s10(x(Eigen::seq(Eigen::fix<1>, EIGEN_LAST, Eigen::fix<2>), Eigen::seq(Eigen::fix<0>, EIGEN_LAST, Eigen::fix<2>)));
-    cfloatmat s11(x(Eigen::seq(Eigen::fix<1>, EIGEN_LAST, Eigen::fix<2>), Eigen::seq(Eigen::fix<1>, EIGEN_LAST, Eigen::fix<2>)));
-    initialize(s00, 4 * offset);
-    initialize(s01, 4 * offset + 4);
-    initialize(s10, 4 * offset + 8);
-    initialize(s11, 4 * offset + 12);
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m256 wj = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double *>(wc + j)));
+      const unsigned int ndiv2j = ndiv2 * j, nj = n * j;
+      unsigned int i = 0;
+      for(; i + 4 <= ndiv2; i += 4) {
+        const unsigned int k = 2 * (i + ndiv2j), k1 = 2 * (i + nj), k2 = k1 + 2 * ndiv2;
 
-    const cfloatmat &x00 = tree_[idx][offset];
-    const cfloatmat &x01 = tree_[idx][offset + 1];
-    const cfloatmat &x10 = tree_[idx][offset + 2];
-    const cfloatmat &x11 = tree_[idx][offset + 3];
-    const unsigned int Nn = N * n;
-    for(unsigned int i = 0; i < ndiv2; i++) {
-      for(unsigned int j = 0; j < ndiv2; j++) {
-        const cfloat tu = twiddle_[j + Nn] * x01(i, j);
-        const cfloat td = twiddle_[(i + j) + Nn] * x11(i, j);
-        const cfloat ts = twiddle_[i + Nn] * x10(i, j);
+        const __m256 wi = _mm256_loadu_ps(fw + 2 * i);
+        const __m256 tu = cmul(wj, _mm256_loadu_ps(f01 + k));
+        const __m256 td = cmul(square ? _mm256_loadu_ps(fw + 2 * (i + j)) : cmul(wi, wj), _mm256_loadu_ps(f11 + k));
+        const __m256 ts = cmul(wi, _mm256_loadu_ps(f10 + k));
 
-        const cfloat a = x00(i, j) + tu;
-        const cfloat b = x00(i, j) - tu;
-        const cfloat c = ts + td;
-        const cfloat d = ts - td;
+        const __m256 x00_k = _mm256_loadu_ps(f00 + k);
+        const __m256 a = _mm256_add_ps(x00_k, tu);
+        const __m256 b = _mm256_sub_ps(x00_k, tu);
+        const __m256 c = _mm256_add_ps(ts, td);
+        const __m256 d = _mm256_sub_ps(ts, td);
 
-        x(i, j) = a + c;
-        x(i, j + ndiv2) = b + d;
-        x(i + ndiv2, j) = a - c;
-        x(i + ndiv2, j + ndiv2) = b - d;
+        _mm256_storeu_ps(fx + k1, _mm256_add_ps(a, c));
+        _mm256_storeu_ps(fx + k1 + 2 * nmdiv2, _mm256_add_ps(b, d));
+        _mm256_storeu_ps(fx + k2, _mm256_sub_ps(a, c));
+        _mm256_storeu_ps(fx + k2 + 2 * nmdiv2, _mm256_sub_ps(b, d));
       }
+      column(x, x00, wr, wc, n, m, j, i);
     }
-    tree_[log2i(n)].emplace_back(x);
   }
+#endif
 
-  /**
-   * @brief Updates the FFT with a single stimulus.
-   *
-   * @param p The stimulus to update.
-   * @return True if the update changed the FFT state, false otherwise.
-   */
-  bool update(const Stimulus &p) { return update(tree_[LOG2_N][0], p); }
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline void avx512(cfloat *x, const cfloat *x00, const cfloat *wr, const cfloat *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const unsigned int nmdiv2 = n * mdiv2;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * mdiv2;
+    const bool square = n == m;
+    const float *f00 = reinterpret_cast<const float *>(x00);
+    const float *f01 = reinterpret_cast<const float *>(x00 + q);
+    const float *f10 = reinterpret_cast<const float *>(x00 + 2 * q);
+    const float *f11 = reinterpret_cast<const float *>(x00 + 3 * q);
+    const float *fw = reinterpret_cast<const float *>(wr);
+    float *fx = reinterpret_cast<float *>(x);
 
-  /**
-   * @brief Updates the FFT with a single stimulus in the specified matrix.
-   *
-   * @param x The matrix to update.
-   * @param p The stimulus to update.
-   * @return True if the update changed the FFT state, false otherwise.
-   */
-  bool update(cfloatmat &x, const Stimulus &p, const unsigned int offset = 0) {
-    const unsigned int n = x.rows();
-    if(n == 1) {
-      return std::exchange(x(0, 0), p.state).real() != static_cast<float>(p.state);
-    }
-    const unsigned int ndiv2 = n >> 1U;
-    const unsigned int nndiv2 = n * ndiv2;
-    const unsigned int idx = log2i(ndiv2);
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m512 wj = _mm512_castpd_ps(_mm512_set1_pd(*reinterpret_cast<const double *>(wc + j)));
+      const unsigned int ndiv2j = ndiv2 * j, nj = n * j;
+      unsigned int i = 0;
+      for(; i + 8 <= ndiv2; i += 8) {
+        const unsigned int k = 2 * (i + ndiv2j), k1 = 2 * (i + nj), k2 = k1 + 2 * ndiv2;
 
-    bool changed = false;
-    if(static_cast<bool>(p.row & 1U)) {
-      if(static_cast<bool>(p.col & 1U)) {
-        changed = update(tree_[idx][offset + 3], {p.row >> 1U, p.col >> 1U, p.state}, 4 * offset + 12); // odd-odd
-      } else {
-        changed = update(tree_[idx][offset + 2], {p.row >> 1U, p.col >> 1U, p.state}, 4 * offset + 8); // odd-even
+        const __m512 wi = _mm512_loadu_ps(fw + 2 * i);
+        const __m512 tu = cmul(wj, _mm512_loadu_ps(f01 + k));
+        const __m512 td = cmul(square ? _mm512_loadu_ps(fw + 2 * (i + j)) : cmul(wi, wj), _mm512_loadu_ps(f11 + k));
+        const __m512 ts = cmul(wi, _mm512_loadu_ps(f10 + k));
+
+        const __m512 x00_k = _mm512_loadu_ps(f00 + k);
+        const __m512 a = _mm512_add_ps(x00_k, tu);
+        const __m512 b = _mm512_sub_ps(x00_k, tu);
+        const __m512 c = _mm512_add_ps(ts, td);
+        const __m512 d = _mm512_sub_ps(ts, td);
+
+        _mm512_storeu_ps(fx + k1, _mm512_add_ps(a, c));
+        _mm512_storeu_ps(fx + k1 + 2 * nmdiv2, _mm512_add_ps(b, d));
+        _mm512_storeu_ps(fx + k2, _mm512_sub_ps(a, c));
+        _mm512_storeu_ps(fx + k2 + 2 * nmdiv2, _mm512_sub_ps(b, d));
       }
-    } else {
-      if(static_cast<bool>(p.col & 1U)) {
-        changed = update(tree_[idx][offset + 1], {p.row >> 1U, p.col >> 1U, p.state}, 4 * offset + 4); // even-odd
-      } else {
-        changed = update(tree_[idx][offset], {p.row >> 1U, p.col >> 1U, p.state}, 4 * offset); // even-even
+      column(x, x00, wr, wc, n, m, j, i);
+    }
+  }
+#endif
+
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline void avx2Half(cfloat *x, const cfloat *x00, const cfloat *wr, const cfloat *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * ((mdiv2 >> 1U) + 1);
+    const bool square = n == m;
+    const float *f00 = reinterpret_cast<const float *>(x00);
+    const float *f01 = reinterpret_cast<const float *>(x00 + q);
+    const float *f10 = reinterpret_cast<const float *>(x00 + 2 * q);
+    const float *f11 = reinterpret_cast<const float *>(x00 + 3 * q);
+    const float *fw = reinterpret_cast<const float *>(wr);
+    float *fx = reinterpret_cast<float *>(x);
+    const __m256 conj = _mm256_set_ps(-0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F);
+
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m256 wj = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double *>(wc + j)));
+      const bool mirror = j > 0 && 2 * j < mdiv2;
+      const unsigned int ndiv2j = ndiv2 * j, nj = n * j, nm = n * (mdiv2 - j);
+      unsigned int i = 0;
+      for(; i + 4 <= ndiv2; i += 4) {
+        const unsigned int k = 2 * (i + ndiv2j), k1 = 2 * (i + nj), k2 = k1 + 2 * ndiv2;
+
+        const __m256 wi = _mm256_loadu_ps(fw + 2 * i);
+        const __m256 tu = cmul(wj, _mm256_loadu_ps(f01 + k));
+        const __m256 td = cmul(square ? _mm256_loadu_ps(fw + 2 * (i + j)) : cmul(wi, wj), _mm256_loadu_ps(f11 + k));
+        const __m256 ts = cmul(wi, _mm256_loadu_ps(f10 + k));
+
+        const __m256 x00_k = _mm256_loadu_ps(f00 + k);
+        const __m256 a = _mm256_add_ps(x00_k, tu);
+        const __m256 b = _mm256_sub_ps(x00_k, tu);
+        const __m256 c = _mm256_add_ps(ts, td);
+        const __m256 d = _mm256_sub_ps(ts, td);
+
+        _mm256_storeu_ps(fx + k1, _mm256_add_ps(a, c));
+        _mm256_storeu_ps(fx + k2, _mm256_sub_ps(a, c));
+        if(j == 0) {
+          _mm256_storeu_ps(fx + 2 * (i + n * mdiv2), _mm256_add_ps(b, d));
+          _mm256_storeu_ps(fx + 2 * (i + ndiv2 + n * mdiv2), _mm256_sub_ps(b, d));
+        } else if(mirror) {
+          const __m256 bd = _mm256_xor_ps(_mm256_add_ps(b, d), conj);
+          if(i > 0) {
+            _mm256_storeu_ps(fx + 2 * (n - i - 3 + nm), reverse(bd));
+          } else { // row 0 mirrors onto itself
+            _mm256_maskstore_ps(fx + 2 * (n - 3 + nm), _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0), reverse(bd));
+            _mm_storel_pi(reinterpret_cast<__m64 *>(fx + 2 * nm), _mm256_castps256_ps128(bd));
+          }
+          _mm256_storeu_ps(fx + 2 * (ndiv2 - i - 3 + nm), reverse(_mm256_xor_ps(_mm256_sub_ps(b, d), conj)));
+        }
       }
+      halfColumn(x, x00, wr, wc, n, m, j, i, ndiv2);
     }
+  }
+#endif
 
-    if(changed) {
-      const cfloat *x00 = tree_[idx][offset].data();
-      const cfloat *x01 = tree_[idx][offset + 1].data();
-      const cfloat *x10 = tree_[idx][offset + 2].data();
-      const cfloat *x11 = tree_[idx][offset + 3].data();
-      cfloat *xp = x.data();
-      const unsigned int Nn = N * n;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline void avx512Half(cfloat *x, const cfloat *x00, const cfloat *wr, const cfloat *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * ((mdiv2 >> 1U) + 1);
+    const bool square = n == m;
+    const float *f00 = reinterpret_cast<const float *>(x00);
+    const float *f01 = reinterpret_cast<const float *>(x00 + q);
+    const float *f10 = reinterpret_cast<const float *>(x00 + 2 * q);
+    const float *f11 = reinterpret_cast<const float *>(x00 + 3 * q);
+    const float *fw = reinterpret_cast<const float *>(wr);
+    float *fx = reinterpret_cast<float *>(x);
 
-      for(unsigned int j = 0; j < ndiv2; j++) {
-        const unsigned int ndiv2j = ndiv2 * j, nj = n * j;
-        for(unsigned int i = 0; i < ndiv2; i++) {
-          const unsigned int k = i + ndiv2j, k1 = i + nj, k2 = k1 + ndiv2;
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m512 wj = _mm512_castpd_ps(_mm512_set1_pd(*reinterpret_cast<const double *>(wc + j)));
+      const bool mirror = j > 0 && 2 * j < mdiv2;
+      const unsigned int ndiv2j = ndiv2 * j, nj = n * j, nm = n * (mdiv2 - j);
+      unsigned int i = 0;
+      for(; i + 8 <= ndiv2; i += 8) {
+        const unsigned int k = 2 * (i + ndiv2j), k1 = 2 * (i + nj), k2 = k1 + 2 * ndiv2;
 
-          const cfloat tu = twiddle_[j + Nn] * x01[k];
-          const cfloat td = twiddle_[i + j + Nn] * x11[k];
-          const cfloat ts = twiddle_[i + Nn] * x10[k];
+        const __m512 wi = _mm512_loadu_ps(fw + 2 * i);
+        const __m512 tu = cmul(wj, _mm512_loadu_ps(f01 + k));
+        const __m512 td = cmul(square ? _mm512_loadu_ps(fw + 2 * (i + j)) : cmul(wi, wj), _mm512_loadu_ps(f11 + k));
+        const __m512 ts = cmul(wi, _mm512_loadu_ps(f10 + k));
 
-          const cfloat x00_k = x00[k];
-          const cfloat a = x00_k + tu;
-          const cfloat b = x00_k - tu;
-          const cfloat c = ts + td;
-          const cfloat d = ts - td;
+        const __m512 x00_k = _mm512_loadu_ps(f00 + k);
+        const __m512 a = _mm512_add_ps(x00_k, tu);
+        const __m512 b = _mm512_sub_ps(x00_k, tu);
+        const __m512 c = _mm512_add_ps(ts, td);
+        const __m512 d = _mm512_sub_ps(ts, td);
 
-          xp[k1] = a + c;
-          xp[k1 + nndiv2] = b + d;
-          xp[k2] = a - c;
-          xp[k2 + nndiv2] = b - d;
+        _mm512_storeu_ps(fx + k1, _mm512_add_ps(a, c));
+        _mm512_storeu_ps(fx + k2, _mm512_sub_ps(a, c));
+        if(j == 0) {
+          _mm512_storeu_ps(fx + 2 * (i + n * mdiv2), _mm512_add_ps(b, d));
+          _mm512_storeu_ps(fx + 2 * (i + ndiv2 + n * mdiv2), _mm512_sub_ps(b, d));
+        } else if(mirror) {
+          const __m512 bd = reverseConj(_mm512_add_ps(b, d));
+          if(i > 0) {
+            _mm512_storeu_ps(fx + 2 * (n - i - 7 + nm), bd);
+          } else { // row 0 mirrors onto itself
+            _mm512_mask_storeu_ps(fx + 2 * (n - 7 + nm), 0x3FFF, bd);
+            _mm_storeh_pi(reinterpret_cast<__m64 *>(fx + 2 * nm), _mm512_extractf32x4_ps(bd, 3));
+          }
+          _mm512_storeu_ps(fx + 2 * (ndiv2 - i - 7 + nm), reverseConj(_mm512_sub_ps(b, d)));
         }
       }
+      halfColumn(x, x00, wr, wc, n, m, j, i, ndiv2);
     }
-    return changed;
   }
+#endif
 
   /**
-   * @brief Updates the FFT with multiple stimuli.
-   *
-   * @param pv The stimuli to update.
-   * @return True if the update changed the FFT state, false otherwise.
+   * @brief Run the widest kernel available (the SIMD kernels are single precision only).
    */
-  bool update(Stimuli &pv) { return update(tree_[LOG2_N][0], pv.begin(), pv.end()); }
+  template <typename T>
+  static inline void run(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    if constexpr(std::is_same_v<T, cfloat>) {
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+      if(n >= 16) {
+        avx512(x, x00, wr, wc, n, m, j0, j1);
+        return;
+      }
+#endif
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+      if(n >= 8) {
+        avx2(x, x00, wr, wc, n, m, j0, j1);
+        return;
+      }
+#endif
+    }
+    scalar(x, x00, wr, wc, n, m, j0, j1);
+  }
 
   /**
-   * @brief Updates the FFT with multiple stimuli in the specified matrix.
-   *
-   * @param x The matrix to update.
-   * @param b0 Iterator pointing to the begining of the stimuli vector.
-   * @param e0 Iterator pointing to the end of the stimuli vector.
-   * @return True if the update changed the FFT state, false otherwise.
+   * @brief Run the widest half-spectrum kernel available (the SIMD kernels are single precision only).
    */
-  bool update(cfloatmat &x, Stimuli::iterator b0, Stimuli::iterator e0, const unsigned int offset = 0) {
-    const unsigned int n = x.rows();
-    if(n == 1) {
-      if(e0 - b0 == 1) {
-        return std::exchange(x(0, 0), b0->state).real() != static_cast<float>(b0->state);
+  template <typename T>
+  static inline void runHalf(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j0, const unsigned int j1) {
+    if constexpr(std::is_same_v<T, cfloat>) {
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+      if(n >= 16) {
+        avx512Half(x, x00, wr, wc, n, m, j0, j1);
+        return;
+      }
+#endif
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+      if(n >= 8) {
+        avx2Half(x, x00, wr, wc, n, m, j0, j1);
+        return;
       }
-      const bool state = std::any_of(b0, e0, [](const Stimulus &p) { return p.state; });
-      return std::exchange(x(0, 0), state).real() != static_cast<float>(state);
+#endif
     }
-    const unsigned int ndiv2 = n >> 1U;
-    const unsigned int nndiv2 = n * ndiv2;
-    const unsigned int idx = log2i(ndiv2);
+    scalarHalf(x, x00, wr, wc, n, m, j0, j1);
+  }
+
+private:
+  /**
+   * @brief Scalar butterflies for rows [i0, n/2) of column j.
+   */
+  template <typename T>
+  static inline void column(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j, const unsigned int i0) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const unsigned int nmdiv2 = n * mdiv2;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * mdiv2;
+    const T *x01 = x00 + q;
+    const T *x10 = x01 + q;
+    const T *x11 = x10 + q;
+    const unsigned int ndiv2j = ndiv2 * j, nj = n * j;
 
-    Stimuli::iterator e1, e2, e3;
-    e2 = std::partition(b0, e0, [](const Stimulus &p) { return p.row & 1U; });
-    e1 = std::partition(b0, e2, [](const Stimulus &p) { return p.col & 1U; });
-    e3 = std::partition(e2, e0, [](const Stimulus &p) { return p.col & 1U; });
+    for(unsigned int i = i0; i < ndiv2; i++) {
+      const unsigned int k = i + ndiv2j, k1 = i + nj, k2 = k1 + ndiv2;
 
-    auto transformStimuli = [](Stimuli::iterator begin, Stimuli::iterator end) {
-      for(auto it = begin; it != end; ++it) {
-        it->row >>= 1U;
-        it->col >>= 1U;
-      }
-    };
-    transformStimuli(b0, e1);
-    transformStimuli(e1, e2);
-    transformStimuli(e2, e3);
-    transformStimuli(e3, e0);
+      const T tu = wc[j] * x01[k];
+      const T td = (n == m ? wr[i + j] : wr[i] * wc[j]) * x11[k];
+      const T ts = wr[i] * x10[k];
 
-    bool changed = false;
-    if(b0 != e1) {
-      changed = update(tree_[idx][offset + 3], b0, e1, 4 * offset + 12) || changed; // odd-odd
-    }
-    if(e1 != e2) {
-      changed = update(tree_[idx][offset + 2], e1, e2, 4 * offset + 8) || changed; // odd-even
-    }
-    if(e2 != e3) {
-      changed = update(tree_[idx][offset + 1], e2, e3, 4 * offset + 4) || changed; // even-odd
+      const T x00_k = x00[k];
+      const T a = x00_k + tu;
+      const T b = x00_k - tu;
+      const T c = ts + td;
+      const T d = ts - td;
+
+      x[k1] = a + c;
+      x[k1 + nmdiv2] = b + d;
+      x[k2] = a - c;
+      x[k2 + nmdiv2] = b - d;
     }
-    if(e3 != e0) {
-      changed = update(tree_[idx][offset], e3, e0, 4 * offset) || changed; // even-even
+  }
+
+  /**
+   * @brief Scalar half-spectrum butterflies for rows [i0, i1) of child column j.
+   */
+  template <typename T>
+  static inline void halfColumn(T *x, const T *x00, const T *wr, const T *wc, const unsigned int n, const unsigned int m, const unsigned int j, const unsigned int i0, const unsigned int i1) {
+    const unsigned int ndiv2 = n >> 1U, mdiv2 = m >> 1U;
+    const std::size_t q = static_cast<std::size_t>(ndiv2) * ((mdiv2 >> 1U) + 1);
+    const T *x01 = x00 + q;
+    const T *x10 = x01 + q;
+    const T *x11 = x10 + q;
+    const unsigned int ndiv2j = ndiv2 * j, nj = n * j, nm = n * (mdiv2 - j);
+
+    for(unsigned int i = i0; i < i1; i++) {
+      const unsigned int k = i + ndiv2j, k1 = i + nj, k2 = k1 + ndiv2;
+
+      const T tu = wc[j] * x01[k];
+      const T td = (n == m ? wr[i + j] : wr[i] * wc[j]) * x11[k];
+      const T ts = wr[i] * x10[k];
+
+      const T x00_k = x00[k];
+      const T a = x00_k + tu;
+      const T b = x00_k - tu;
+      const T c = ts + td;
+      const T d = ts - td;
+
+      x[k1] = a + c;
+      x[k2] = a - c;
+      if(j == 0) {
+        x[i + n * mdiv2] = b + d;
+        x[i + ndiv2 + n * mdiv2] = b - d;
+      } else if(2 * j < mdiv2) {
+        x[(n - i) % n + nm] = std::conj(b + d);
+        x[ndiv2 - i + nm] = std::conj(b - d);
+      }
     }
+  }
 
-    if(changed) {
-      const cfloat *x00 = tree_[idx][offset].data();
-      const cfloat *x01 = tree_[idx][offset + 1].data();
-      const cfloat *x10 = tree_[idx][offset + 2].data();
-      const cfloat *x11 = tree_[idx][offset + 3].data();
-      cfloat *xp = x.data();
-      const unsigned int Nn = N * n;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline __m256 reverse(const __m256 a) {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(a), 0x1B));
+  }
+#endif
+
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline __m512 reverseConj(const __m512 a) {
+    const __m512i conj = _mm512_set_epi32(INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0);
+    const __m512 c = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), conj));
+    return _mm512_castpd_ps(_mm512_permutexvar_pd(_mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_castps_pd(c)));
+  }
+#endif
+
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline __m256 cmul(const __m256 a, const __m256 b) {
+    const __m256 re = _mm256_moveldup_ps(b);
+    const __m256 im = _mm256_movehdup_ps(b);
+    return _mm256_fmaddsub_ps(a, re, _mm256_mul_ps(_mm256_permute_ps(a, 0xB1), im));
+  }
+#endif
+
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline __m512 cmul(const __m512 a, const __m512 b) {
+    const __m512 re = _mm512_moveldup_ps(b);
+    const __m512 im = _mm512_movehdup_ps(b);
+    return _mm512_fmaddsub_ps(a, re, _mm512_mul_ps(_mm512_permute_ps(a, 0xB1), im));
+  }
+#endif
+};
+
+/**
+ * @brief Radix-4x4 butterfly kernels.
+ *
+ * A kernel recombines the columns [j0, j1) of the first quarter of an n x n node (column-major) from its sixteen
+ * (n/4) x (n/4) grandchildren, stored contiguously in leaf order starting at x0. Grandchild 8r0 + 4c0 + 2r1 + c1 holds the
+ * sub-image of the pixels whose local coordinates are (r0 + 2r1, c0 + 2c1) modulo 4. Every output group
+ * (i + a n/4, j + b n/4) is a 4x4 DFT of the twiddled grandchildren, done as 4-point DFTs along the rows and then along
+ * the columns. The twiddle factors are read as wk[i] = exp(-2πiki/n) for 0 <= i < n/4 and k = 1, 2, 3.
+ */
+struct Butterfly4 {
+  template <typename T>
+  static inline void scalar(T *x, const T *x0, const T *w1, const T *w2, const T *w3, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    for(unsigned int j = j0; j < j1; j++) {
+      column(x, x0, w1, w2, w3, n, j, 0);
+    }
+  }
 
-      for(unsigned int j = 0; j < ndiv2; j++) {
-        const unsigned int ndiv2j = ndiv2 * j, nj = n * j;
-        for(unsigned int i = 0; i < ndiv2; i++) {
-          const unsigned int k = i + ndiv2j, k1 = i + nj, k2 = k1 + ndiv2;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline void avx2(cfloat *x, const cfloat *x0, const cfloat *w1, const cfloat *w2, const cfloat *w3, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv4 = n >> 2U;
+    const std::size_t q = static_cast<std::size_t>(ndiv4) * ndiv4;
+    const float *f0 = reinterpret_cast<const float *>(x0);
+    float *fx = reinterpret_cast<float *>(x);
+    const __m256 sign = _mm256_set_ps(-0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F);
 
-          const cfloat tu = twiddle_[j + Nn] * x01[k];
-          const cfloat td = twiddle_[i + j + Nn] * x11[k];
-          const cfloat ts = twiddle_[i + Nn] * x10[k];
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m256 cw[4] = {_mm256_setzero_ps(), broadcast256(w1 + j), broadcast256(w2 + j), broadcast256(w3 + j)};
+      unsigned int i = 0;
+      for(; i + 4 <= ndiv4; i += 4) {
+        const std::size_t k = 2 * (i + static_cast<std::size_t>(ndiv4) * j);
+        const __m256 rw[4] = {_mm256_setzero_ps(), _mm256_loadu_ps(reinterpret_cast<const float *>(w1 + i)), _mm256_loadu_ps(reinterpret_cast<const float *>(w2 + i)), _mm256_loadu_ps(reinterpret_cast<const float *>(w3 + i))};
+        __m256 y[4][4];
+        for(unsigned int c = 0; c < 4; c++) {
+          __m256 t[4];
+          for(unsigned int r = 0; r < 4; r++) {
+            const __m256 g = _mm256_loadu_ps(f0 + 2 * q * GRANDCHILD[r][c] + k);
+            t[r] = r ? cmul(rw[r], g) : g;
+          }
+          dft4(t, sign);
+          for(unsigned int a = 0; a < 4; a++) {
+            y[a][c] = t[a];
+          }
+        }
+        for(unsigned int a = 0; a < 4; a++) {
+          for(unsigned int c = 1; c < 4; c++) {
+            y[a][c] = cmul(cw[c], y[a][c]);
+          }
+          dft4(y[a], sign);
+          for(unsigned int b = 0; b < 4; b++) {
+            _mm256_storeu_ps(fx + 2 * (i + a * ndiv4 + static_cast<std::size_t>(n) * (j + b * ndiv4)), y[a][b]);
+          }
+        }
+      }
+      column(x, x0, w1, w2, w3, n, j, i);
+    }
+  }
+#endif
 
-          const cfloat x00_k = x00[k];
-          const cfloat a = x00_k + tu;
-          const cfloat b = x00_k - tu;
-          const cfloat c = ts + td;
-          const cfloat d = ts - td;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline void avx512(cfloat *x, const cfloat *x0, const cfloat *w1, const cfloat *w2, const cfloat *w3, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    const unsigned int ndiv4 = n >> 2U;
+    const std::size_t q = static_cast<std::size_t>(ndiv4) * ndiv4;
+    const float *f0 = reinterpret_cast<const float *>(x0);
+    float *fx = reinterpret_cast<float *>(x);
+    const __m512i sign = _mm512_set_epi32(INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0);
 
-          xp[k1] = a + c;
-          xp[k1 + nndiv2] = b + d;
-          xp[k2] = a - c;
-          xp[k2 + nndiv2] = b - d;
+    for(unsigned int j = j0; j < j1; j++) {
+      const __m512 cw[4] = {_mm512_setzero_ps(), broadcast512(w1 + j), broadcast512(w2 + j), broadcast512(w3 + j)};
+      unsigned int i = 0;
+      for(; i + 8 <= ndiv4; i += 8) {
+        const std::size_t k = 2 * (i + static_cast<std::size_t>(ndiv4) * j);
+        const __m512 rw[4] = {_mm512_setzero_ps(), _mm512_loadu_ps(reinterpret_cast<const float *>(w1 + i)), _mm512_loadu_ps(reinterpret_cast<const float *>(w2 + i)), _mm512_loadu_ps(reinterpret_cast<const float *>(w3 + i))};
+        __m512 y[4][4];
+        for(unsigned int c = 0; c < 4; c++) {
+          __m512 t[4];
+          for(unsigned int r = 0; r < 4; r++) {
+            const __m512 g = _mm512_loadu_ps(f0 + 2 * q * GRANDCHILD[r][c] + k);
+            t[r] = r ? cmul(rw[r], g) : g;
+          }
+          dft4(t, sign);
+          for(unsigned int a = 0; a < 4; a++) {
+            y[a][c] = t[a];
+          }
+        }
+        for(unsigned int a = 0; a < 4; a++) {
+          for(unsigned int c = 1; c < 4; c++) {
+            y[a][c] = cmul(cw[c], y[a][c]);
+          }
+          dft4(y[a], sign);
+          for(unsigned int b = 0; b < 4; b++) {
+            _mm512_storeu_ps(fx + 2 * (i + a * ndiv4 + static_cast<std::size_t>(n) * (j + b * ndiv4)), y[a][b]);
+          }
         }
       }
+      column(x, x0, w1, w2, w3, n, j, i);
     }
-    return changed;
   }
+#endif
 
-#ifdef EFFT_USE_FFTW3
   /**
-   * @brief Initialize the FFT ground truth (FFTW) using the given image.
-   *
-   * @param image A complex float matrix to initialize the FFT input. Defaults to a zero matrix.
+   * @brief Run the widest kernel available (the SIMD kernels are single precision only).
    */
-  void initializeGroundTruth(const cfloatmat &image = cfloatmat::Zero(N, N)) {
-    plan_ = fftw_plan_dft_2d(N, N, fftwInput_, fftwOutput_, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED | FFTW_NO_SIMD | FFTW_PRESERVE_INPUT);
-    for(Eigen::Index i = 0; i < image.rows(); i++) {
-      for(Eigen::Index j = 0; j < image.cols(); j++) {
-        fftwInput_[N * i + j][0] = image(i, j).real();
-        fftwInput_[N * i + j][1] = image(i, j).imag();
+  template <typename T>
+  static inline void run(T *x, const T *x0, const T *w1, const T *w2, const T *w3, const unsigned int n, const unsigned int j0, const unsigned int j1) {
+    if constexpr(std::is_same_v<T, cfloat>) {
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+      if(n >= 32) {
+        avx512(x, x0, w1, w2, w3, n, j0, j1);
+        return;
+      }
+#endif
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+      if(n >= 16) {
+        avx2(x, x0, w1, w2, w3, n, j0, j1);
+        return;
       }
+#endif
     }
-    fftw_execute(plan_);
+    scalar(x, x0, w1, w2, w3, n, j0, j1);
   }
 
+private:
+  static constexpr unsigned int GRANDCHILD[4][4] = {{0, 4, 1, 5}, {8, 12, 9, 13}, {2, 6, 3, 7}, {10, 14, 11, 15}}; // [row][col] mod 4
+
   /**
-   * @brief Update the FFT ground truth (FFTW) with a single stimulus.
-   *
-   * @param p The stimulus to update.
+   * @brief In-place 4-point DFT.
    */
-  void updateGroundTruth(const Stimulus &p) {
-    fftwInput_[N * p.row + p.col][0] = static_cast<double>(p.state);
-    fftwInput_[N * p.row + p.col][1] = 0;
-    fftw_execute(plan_);
+  template <typename T>
+  static inline void dft4(std::array<T, 4> &t) {
+    const T s0 = t[0] + t[2], s1 = t[0] - t[2], s2 = t[1] + t[3], d = t[1] - t[3];
+    const T s3{d.imag(), -d.real()}; // -i(t1 - t3)
+    t[0] = s0 + s2;
+    t[1] = s1 + s3;
+    t[2] = s0 - s2;
+    t[3] = s1 - s3;
   }
 
   /**
-   * @brief Update the FFT ground truth (FFTW) with multiple stimuli.
-   *
-   * @param pv The stimuli to update.
+   * @brief Scalar butterflies for rows [i0, n/4) of column j.
    */
-  void updateGroundTruth(const Stimuli &pv) {
-    std::set<std::pair<unsigned int, unsigned int>> activated;
-    for(const Stimulus &p : pv) {
-      if(p.state) {
-        activated.insert({p.row, p.col});
-      } else if(activated.find({p.row, p.col}) != activated.end()) {
-        continue;
+  template <typename T>
+  static inline void column(T *x, const T *x0, const T *w1, const T *w2, const T *w3, const unsigned int n, const unsigned int j, const unsigned int i0) {
+    const unsigned int ndiv4 = n >> 2U;
+    const std::size_t q = static_cast<std::size_t>(ndiv4) * ndiv4;
+    const std::array<T, 4> cw{T{1, 0}, w1[j], w2[j], w3[j]};
+
+    for(unsigned int i = i0; i < ndiv4; i++) {
+      const std::size_t k = i + static_cast<std::size_t>(ndiv4) * j;
+      const std::array<T, 4> rw{T{1, 0}, w1[i], w2[i], w3[i]};
+      std::array<std::array<T, 4>, 4> y;
+      for(unsigned int c = 0; c < 4; c++) {
+        std::array<T, 4> t;
+        for(unsigned int r = 0; r < 4; r++) {
+          t[r] = rw[r] * x0[q * GRANDCHILD[r][c] + k];
+        }
+        dft4(t);
+        for(unsigned int a = 0; a < 4; a++) {
+          y[a][c] = t[a];
+        }
+      }
+      for(unsigned int a = 0; a < 4; a++) {
+        for(unsigned int c = 1; c < 4; c++) {
+          y[a][c] *= cw[c];
+        }
+        dft4(y[a]);
+        for(unsigned int b = 0; b < 4; b++) {
+          x[i + a * ndiv4 + static_cast<std::size_t>(n) * (j + b * ndiv4)] = y[a][b];
+        }
       }
-      fftwInput_[N * p.row + p.col][0] = static_cast<double>(p.state);
-      fftwInput_[N * p.row + p.col][1] = 0;
     }
-    fftw_execute(plan_);
+  }
+
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX2__) && defined(__FMA__)
+  static inline __m256 broadcast256(const cfloat *w) {
+    return _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double *>(w)));
+  }
+
+  static inline void dft4(__m256 (&t)[4], const __m256 sign) {
+    const __m256 s0 = _mm256_add_ps(t[0], t[2]), s1 = _mm256_sub_ps(t[0], t[2]), s2 = _mm256_add_ps(t[1], t[3]);
+    const __m256 s3 = _mm256_xor_ps(_mm256_permute_ps(_mm256_sub_ps(t[1], t[3]), 0xB1), sign); // -i(t1 - t3)
+    t[0] = _mm256_add_ps(s0, s2);
+    t[1] = _mm256_add_ps(s1, s3);
+    t[2] = _mm256_sub_ps(s0, s2);
+    t[3] = _mm256_sub_ps(s1, s3);
+  }
+
+  static inline __m256 cmul(const __m256 a, const __m256 b) {
+    const __m256 re = _mm256_moveldup_ps(b);
+    const __m256 im = _mm256_movehdup_ps(b);
+    return _mm256_fmaddsub_ps(a, re, _mm256_mul_ps(_mm256_permute_ps(a, 0xB1), im));
   }
 #endif
 
-  /**
-   * @brief Get the FFT result as an Eigen matrix of complex floats.
-   *
-   * @return The FFT result.
-   */
-  [[nodiscard]] inline const cfloatmat &getFFT() const {
-    return tree_[LOG2_N][0];
+#if !defined(EFFT_DISABLE_SIMD) && defined(__AVX512F__)
+  static inline __m512 broadcast512(const cfloat *w) {
+    return _mm512_castpd_ps(_mm512_set1_pd(*reinterpret_cast<const double *>(w)));
   }
 
-#ifdef EFFT_USE_FFTW3
-  /**
-   * @brief Get the FFT ground truth (FFTW) result as an Eigen matrix of complex floats.
-   *
-   * @return The ground truth FFT result.
-   */
-  [[nodiscard]] inline cfloatmat getGroundTruthFFT() const {
-    return Eigen::Map<const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(reinterpret_cast<const std::complex<double> *>(fftwOutput_), N, N).template cast<cfloat>();
+  static inline void dft4(__m512 (&t)[4], const __m512i sign) {
+    const __m512 s0 = _mm512_add_ps(t[0], t[2]), s1 = _mm512_sub_ps(t[0], t[2]), s2 = _mm512_add_ps(t[1], t[3]);
+    const __m512 s3 = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_permute_ps(_mm512_sub_ps(t[1], t[3]), 0xB1)), sign)); // -i(t1 - t3)
+    t[0] = _mm512_add_ps(s0, s2);
+    t[1] = _mm512_add_ps(s1, s3);
+    t[2] = _mm512_sub_ps(s0, s2);
+    t[3] = _mm512_sub_ps(s1, s3);
   }
 
+  static inline __m512 cmul(const __m512 a, const __m512 b) {
+    const __m512 re = _mm512_moveldup_ps(b);
+    const __m512 im = _mm512_movehdup_ps(b);
+    return _mm512_fmaddsub_ps(a, re, _mm512_mul_ps(_mm512_permute_ps(a, 0xB1), im));
+  }
+#endif
+};
+
+/**
+ * @brief Spectra of 4 x 4 binary tiles.
+ *
+ * The 16 pixels of a tile are numbered in leaf (Morton) order, so the spectrum of a tile is the sum of the spectra of
+ * its two bytes. The table holds the spectrum of every byte value at both positions, in node layout (column-major, all
+ * the columns or only 0..2 for half spectra), and is shared by all the instances with the same element type T.
+ */
+template <bool HALF, typename T = cfloat>
+struct LeafTile {
+  static constexpr unsigned int COLS = HALF ? 3 : 4;
+  static constexpr unsigned int SIZE = 4 * COLS;
+
   /**
-   * @brief Check the difference between the computed FFT and the ground truth FFT (FFTW).
+   * @brief Write the spectrum of a tile.
    *
-   * @return The norm of the difference between the computed FFT and the ground truth FFT.
+   * @param x Output node.
+   * @param bits The 16 pixels of the tile, in leaf order.
    */
-  [[nodiscard]] inline double check() const {
-    return (getFFT() - getGroundTruthFFT()).norm();
+  static inline void run(T *x, const uint32_t bits) {
+    const T *lo = table().data() + static_cast<std::size_t>(bits & 0xFFU) * SIZE;
+    const T *hi = table().data() + static_cast<std::size_t>(256 + ((bits >> 8U) & 0xFFU)) * SIZE;
+    for(unsigned int k = 0; k < SIZE; k++) {
+      x[k] = lo[k] + hi[k];
+    }
+  }
+
+private:
+  static const std::vector<T> &table() {
+    static const std::vector<T> spectra = build();
+    return spectra;
+  }
+
+  static std::vector<T> build() {
+    constexpr std::array<T, 4> W{T{1, 0}, T{0, -1}, T{-1, 0}, T{0, 1}}; // exp(-2πik/4)
+    std::vector<T> spectra(2 * 256 * SIZE);
+    for(unsigned int bit = 0; bit < 16; bit++) {
+      // leaf order interleaves the bit-reversed row and column (row bit first)
+      const unsigned int r = ((bit >> 3U) & 1U) | (((bit >> 1U) & 1U) << 1U);
+      const unsigned int c = ((bit >> 2U) & 1U) | ((bit & 1U) << 1U);
+      for(unsigned int pattern = 0; pattern < 256; pattern++) {
+        if(!((pattern >> (bit & 7U)) & 1U)) {
+          continue;
+        }
+        T *x = spectra.data() + static_cast<std::size_t>((bit >> 3U) * 256 + pattern) * SIZE;
+        for(unsigned int v = 0; v < COLS; v++) {
+          for(unsigned int u = 0; u < 4; u++) {
+            x[u + 4 * v] += W[(u * r + v * c) & 3U];
+          }
+        }
+      }
+    }
+    return spectra;
+  }
+};
+
+/**
+ * @brief Twiddle factors of the transforms of size up to 2^LOG2_N.
+ *
+ * The tables are computed once, on first use, and shared read-only by all the instances with the same element type T
+ * and size.
+ */
+template <typename T, unsigned int LOG2_N>
+struct Twiddles {
+  static constexpr std::size_t N = std::size_t{1} << LOG2_N;
+
+  /**
+   * @brief Get the twiddle factors of every size: w()[n + k] = exp(-2πik/n) for every power of two n <= N and 0 <= k < n.
+   */
+  static const T *w() {
+    return tables().first.data();
+  }
+
+  /**
+   * @brief Get the radix-4 twiddle factors of every size: w3()[n/4 + k] = exp(-2πi3k/n) for 4 <= n <= N and 0 <= k < n/4.
+   */
+  static const T *w3() {
+    return tables().second.data();
+  }
+
+  /**
+   * @brief Get the memory used by the tables.
+   */
+  static constexpr std::size_t footprint() {
+    return (2 * N + std::max(N / 2, std::size_t{1})) * sizeof(T);
+  }
+
+private:
+  using Tables = std::pair<std::vector<T>, std::vector<T>>;
+
+  static const Tables &tables() {
+    static const Tables twiddles = build();
+    return twiddles;
+  }
+
+  static Tables build() {
+    constexpr double MINUS_TWO_PI = -2 * 3.14159265358979323846;
+    Tables twiddles{std::vector<T>(2 * N), std::vector<T>(std::max(N / 2, std::size_t{1}))};
+    twiddles.first[0] = T{1, 0};
+    for(std::size_t n = 1; n <= N; n <<= 1U) {
+      for(std::size_t k = 0; k < n; k++) {
+        twiddles.first[n + k] = static_cast<T>(std::polar(1.0, MINUS_TWO_PI * static_cast<double>(k) / static_cast<double>(n)));
+      }
+    }
+    for(std::size_t n = 4; n <= N; n <<= 1U) {
+      for(std::size_t k = 0; k < n / 4; k++) {
+        twiddles.second[n / 4 + k] = static_cast<T>(std::polar(1.0, MINUS_TWO_PI * static_cast<double>(3 * k) / static_cast<double>(n)));
+      }
+    }
+    return twiddles;
+  }
+};
+
+/**
+ * @brief Work-stealing thread pool.
+ *
+ * Every worker owns a deque: it pushes and pops its own tasks at the back and steals from the front of the others
+ * when it runs dry. Tasks submitted from outside the pool go to a shared deque. Threads waiting on a TaskGroup run
+ * pending tasks instead of blocking, so tasks can spawn and wait for subtasks.
+ */
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * @brief Group of tasks that can be waited for.
+   */
+  class TaskGroup {
+  public:
+    explicit TaskGroup(ThreadPool &pool) : pool_{pool} {}
+    ~TaskGroup() { wait(); }
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /**
+     * @brief Submit a task to the pool.
+     *
+     * @param f The callable to run.
+     */
+    template <typename F>
+    void run(F &&f) {
+      pending_.fetch_add(1, std::memory_order_relaxed);
+      pool_.submit([this, f = std::forward<F>(f)]() mutable {
+        f();
+        pending_.fetch_sub(1, std::memory_order_release);
+      });
+    }
+
+    /**
+     * @brief Wait for all the tasks of the group, running pending tasks meanwhile.
+     */
+    void wait() {
+      while(pending_.load(std::memory_order_acquire) > 0) {
+        if(!pool_.runOne()) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+  private:
+    ThreadPool &pool_;
+    std::atomic<unsigned int> pending_{0};
+  };
+
+  /**
+   * @brief Create a pool.
+   *
+   * @param threads Number of threads, including the calling thread (which helps while waiting).
+   */
+  explicit ThreadPool(const unsigned int threads) : queues_{new Queue[std::max(threads, 1U)]} {
+    for(unsigned int i = 1; i < threads; i++) {
+      workers_.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for(std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+  /**
+   * @brief Get the number of threads, including the calling thread.
+   * @return The number of threads.
+   */
+  [[nodiscard]] unsigned int size() const {
+    return static_cast<unsigned int>(workers_.size()) + 1;
+  }
+
+  /**
+   * @brief Submit a task.
+   *
+   * @param task The task to run.
+   */
+  void submit(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_++;
+    }
+    Queue &queue = queues_[self()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  /**
+   * @brief Run one pending task, if any.
+   * @return True if a task was run, false otherwise.
+   */
+  bool runOne() {
+    Task task;
+    if(!pop(self(), task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  /**
+   * @brief Run f(begin, end) over chunks of [first, last) in parallel.
+   *
+   * @param first First index.
+   * @param last Past-the-end index.
+   * @param f The callable, invoked with the bounds of each chunk.
+   */
+  template <typename F>
+  void parallelFor(const std::size_t first, const std::size_t last, const F &f) {
+    const std::size_t count = last - first;
+    const std::size_t chunks = std::min<std::size_t>(count, 4 * static_cast<std::size_t>(size()));
+    if(chunks <= 1) {
+      f(first, last);
+      return;
+    }
+    TaskGroup group(*this);
+    for(std::size_t c = 1; c < chunks; c++) {
+      group.run([&f, b = first + count * c / chunks, e = first + count * (c + 1) / chunks] { f(b, e); });
+    }
+    f(first, first + count / chunks);
+    group.wait();
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::unique_ptr<Queue[]> queues_;
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t pending_{0};
+  bool stop_{false};
+  static inline thread_local const ThreadPool *owner_{nullptr};
+  static inline thread_local unsigned int index_{0};
+
+  [[nodiscard]] unsigned int self() const {
+    return owner_ == this ? index_ : 0;
+  }
+
+  bool pop(const unsigned int self, Task &task) {
+    const unsigned int n = size();
+    for(unsigned int k = 0; k < n; k++) {
+      Queue &queue = queues_[(self + k) % n];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if(queue.tasks.empty()) {
+        continue;
+      }
+      if(k == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      std::lock_guard<std::mutex> count(mutex_);
+      pending_--;
+      return true;
+    }
+    return false;
+  }
+
+  void work(const unsigned int index) {
+    owner_ = this;
+    index_ = index;
+    Task task;
+    while(true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if(stop_) {
+          return;
+        }
+      }
+      if(pop(index, task)) {
+        task();
+        task = nullptr;
+      }
+    }
+  }
+};
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer.
+ *
+ * The producer only writes the tail and the consumer only writes the head, each on its own cache line, and both keep a
+ * cached copy of the other index so they only touch the shared line when the ring looks full or empty.
+ *
+ * @tparam T Element type (trivially copyable).
+ */
+template <typename T>
+class SpscRing {
+public:
+  /**
+   * @brief Create a ring.
+   *
+   * @param capacity Minimum number of elements, rounded up to a power of two.
+   */
+  explicit SpscRing(const std::size_t capacity) : buffer_(std::size_t{1} << ceilLog2(std::max<std::size_t>(capacity, 2))), mask_{buffer_.size() - 1} {}
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /**
+   * @brief Get the number of elements the ring can hold.
+   * @return The capacity.
+   */
+  [[nodiscard]] std::size_t capacity() const {
+    return buffer_.size();
+  }
+
+  /**
+   * @brief Push elements, as many as fit (producer side).
+   *
+   * @param pv Pointer to the first element.
+   * @param count Number of elements.
+   * @return The number of elements pushed.
+   */
+  std::size_t push(const T *pv, const std::size_t count) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail + count - headCache_ > buffer_.size()) {
+      headCache_ = head_.load(std::memory_order_acquire);
+    }
+    const std::size_t n = std::min(count, buffer_.size() - (tail - headCache_));
+    const std::size_t first = std::min(n, buffer_.size() - (tail & mask_));
+    std::copy(pv, pv + first, buffer_.begin() + static_cast<std::ptrdiff_t>(tail & mask_));
+    std::copy(pv + first, pv + n, buffer_.begin());
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @brief Pop elements, up to a number of them (consumer side).
+   *
+   * @param out Output vector, resized to the elements popped.
+   * @param count Maximum number of elements.
+   * @return The number of elements popped.
+   */
+  template <typename Vector>
+  std::size_t pop(Vector &out, const std::size_t count) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if(tailCache_ - head < count) {
+      tailCache_ = tail_.load(std::memory_order_acquire);
+    }
+    const std::size_t n = std::min(count, tailCache_ - head);
+    const std::size_t first = std::min(n, buffer_.size() - (head & mask_));
+    out.resize(n);
+    std::copy(buffer_.begin() + static_cast<std::ptrdiff_t>(head & mask_), buffer_.begin() + static_cast<std::ptrdiff_t>((head & mask_) + first), out.begin());
+    std::copy(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(n - first), out.begin() + static_cast<std::ptrdiff_t>(first));
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @brief Check whether the ring is empty (consumer side).
+   * @return True if there is nothing to pop, false otherwise.
+   */
+  [[nodiscard]] bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::vector<T> buffer_;
+  const std::size_t mask_;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t tailCache_{0}; // consumer's copy of the tail
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t headCache_{0}; // producer's copy of the head
+
+  static constexpr unsigned int ceilLog2(const std::size_t n) {
+    unsigned int bits = 0;
+    while((std::size_t{1} << bits) < n) {
+      bits++;
+    }
+    return bits;
+  }
+};
+
+/**
+ * @brief How a single stimulus is propagated from its leaf to the root.
+ */
+enum class Propagation {
+  Tree, ///< Recombine every ancestor from its four children (radix-2x2 butterflies).
+  Delta ///< Add the rank-1 change exp(-2πi(ur+vc)/n) of the flipped pixel to every ancestor.
+};
+
+/**
+ * @brief Brain floating point storage format: the upper half of an IEEE single, rounded to nearest even.
+ *
+ * It keeps the range of float with an 8-bit significand (relative error below 2^-9).
+ */
+struct bfloat16 {
+  static inline uint16_t encode(const float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    if((u & 0x7FFFFFFFU) > 0x7F800000U) {
+      return static_cast<uint16_t>((u >> 16U) | 0x40U); // keep NaNs quiet
+    }
+    return static_cast<uint16_t>((u + 0x7FFFU + ((u >> 16U) & 1U)) >> 16U);
+  }
+
+  static inline float decode(const uint16_t h) {
+    const uint32_t u = static_cast<uint32_t>(h) << 16U;
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+  }
+
+  /**
+   * @brief Encode n values.
+   */
+  static inline void encode(const float *x, uint16_t *h, const std::size_t n) {
+    for(std::size_t k = 0; k < n; k++) {
+      h[k] = encode(x[k]);
+    }
+  }
+
+  /**
+   * @brief Decode n values.
+   */
+  static inline void decode(const uint16_t *h, float *x, const std::size_t n) {
+    for(std::size_t k = 0; k < n; k++) {
+      x[k] = decode(h[k]);
+    }
+  }
+};
+
+/**
+ * @brief IEEE half precision storage format, rounded to nearest even.
+ *
+ * It has an 11-bit significand (relative error below 2^-11) but overflows above 65504. The bulk conversions use F16C
+ * when the compiler targets it.
+ */
+struct float16 {
+  static inline uint16_t encode(const float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    const uint32_t sign = (u >> 16U) & 0x8000U;
+    const uint32_t mantissa = u & 0x7FFFFFU;
+    const int exponent = static_cast<int>((u >> 23U) & 0xFFU) - 127 + 15;
+    if(((u >> 23U) & 0xFFU) == 0xFFU) {
+      return static_cast<uint16_t>(sign | 0x7C00U | (mantissa ? 0x200U : 0U)); // infinity or NaN
+    }
+    if(exponent >= 31) {
+      return static_cast<uint16_t>(sign | 0x7C00U);
+    }
+    uint32_t h;
+    uint32_t rest;
+    uint32_t halfway;
+    if(exponent <= 0) { // subnormal
+      if(exponent < -10) {
+        return static_cast<uint16_t>(sign);
+      }
+      const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+      h = (mantissa | 0x800000U) >> shift;
+      rest = (mantissa | 0x800000U) & ((1U << shift) - 1);
+      halfway = 1U << (shift - 1);
+    } else {
+      h = (static_cast<uint32_t>(exponent) << 10U) | (mantissa >> 13U);
+      rest = mantissa & 0x1FFFU;
+      halfway = 0x1000U;
+    }
+    if(rest > halfway || (rest == halfway && (h & 1U))) {
+      h++; // a carry into the exponent is still the right rounding, up to infinity
+    }
+    return static_cast<uint16_t>(sign | h);
+  }
+
+  static inline float decode(const uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000U) << 16U;
+    const uint32_t exponent = (h >> 10U) & 0x1FU;
+    const uint32_t mantissa = h & 0x3FFU;
+    if(exponent == 0) {
+      const float x = std::ldexp(static_cast<float>(mantissa), -24);
+      return sign ? -x : x;
+    }
+    const uint32_t u = sign | (exponent == 31 ? 0x7F800000U : (exponent + 112) << 23U) | (mantissa << 13U);
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+  }
+
+  /**
+   * @brief Encode n values.
+   */
+  static inline void encode(const float *x, uint16_t *h, const std::size_t n) {
+    std::size_t k = 0;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__F16C__)
+    for(; k + 8 <= n; k += 8) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(h + k), _mm256_cvtps_ph(_mm256_loadu_ps(x + k), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+    for(; k < n; k++) {
+      h[k] = encode(x[k]);
+    }
+  }
+
+  /**
+   * @brief Decode n values.
+   */
+  static inline void decode(const uint16_t *h, float *x, const std::size_t n) {
+    std::size_t k = 0;
+#if !defined(EFFT_DISABLE_SIMD) && defined(__F16C__)
+    for(; k + 8 <= n; k += 8) {
+      _mm256_storeu_ps(x + k, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + k))));
+    }
+#endif
+    for(; k < n; k++) {
+      x[k] = decode(h[k]);
+    }
+  }
+};
+
+/**
+ * @brief Compile-time options of eFFT.
+ */
+struct eFFTTraits {
+  static constexpr bool HALF_SPECTRUM = false; ///< Store only the columns 0..n/2 of every node (real input only).
+  static constexpr unsigned int LEAF_BLOCK = 1; ///< Bottom node size: 1 (pixel leaves), 4 or 8 (bit tiles).
+  static constexpr unsigned int RADIX = 2;      ///< Radix of the levels: 2, or 4 to store every other level only.
+  using Scalar = float;                         ///< Arithmetic type of the butterflies and of the stored levels: float or double.
+  using Compact = bfloat16;                     ///< 16-bit format of the compact levels: bfloat16 or float16.
+  static constexpr unsigned int COMPACT_LEVELS = 0; ///< Number of levels, from the bottom node size up, kept in the Compact format.
+};
+
+/**
+ * @brief Options of the real-input engine, which stores and updates half spectra.
+ */
+struct eFFTHalfSpectrumTraits : eFFTTraits {
+  static constexpr bool HALF_SPECTRUM = true;
+};
+
+/**
+ * @brief Event-based FFT of a W x H frame (W columns, H rows), both powers of two.
+ *
+ * The tree splits both axes at every level, from the root down, until the shorter axis runs out. The LINES levels below
+ * only split the longer axis, so the bottom nodes are lines of pixels. Square frames have no such levels.
+ */
+template <unsigned int W, unsigned int H = W, typename Traits = eFFTTraits>
+class eFFT {
+private:
+  static constexpr bool HALF = Traits::HALF_SPECTRUM;
+  static constexpr unsigned int LOG2_W = LOG2(W);
+  static constexpr unsigned int LOG2_H = LOG2(H);
+  static constexpr unsigned int ROOT = LOG2_W > LOG2_H ? LOG2_W : LOG2_H;        // level of the root
+  static constexpr unsigned int LINES = LOG2_W > LOG2_H ? ROOT - LOG2_H : ROOT - LOG2_W; // levels that split one axis
+  static constexpr std::size_t AREA = static_cast<std::size_t>(W) * static_cast<std::size_t>(H);
+  static constexpr unsigned int BOTTOM = LOG2(Traits::LEAF_BLOCK); // lowest stored level
+  static constexpr bool BLOCKED = BOTTOM > 0;
+  static constexpr unsigned int RADIX = Traits::RADIX;
+  using Scalar = typename Traits::Scalar;
+  using Compact = typename Traits::Compact;
+  using complex = std::complex<Scalar>;
+  using matrix = Eigen::Matrix<complex, Eigen::Dynamic, Eigen::Dynamic>;
+  static constexpr unsigned int COMPACT_TOP = BOTTOM + Traits::COMPACT_LEVELS; // levels below are stored in 16 bits
+  static_assert(Traits::LEAF_BLOCK == 1 || Traits::LEAF_BLOCK == 4 || Traits::LEAF_BLOCK == 8, "eFFT leaf block must be 1, 4 or 8");
+  static_assert(Traits::LEAF_BLOCK <= W, "eFFT leaf block must not exceed the frame size");
+  static_assert(W == H || (Traits::LEAF_BLOCK == 1 && Traits::RADIX == 2), "eFFT rectangular frames need pixel leaves and radix-2 levels");
+  static_assert(RADIX == 2 || RADIX == 4, "eFFT radix must be 2 or 4");
+  static_assert(RADIX == 2 || !HALF, "eFFT radix-4 levels only support full spectra");
+  static_assert(std::is_same_v<Scalar, float> || std::is_same_v<Scalar, double>, "eFFT scalar must be float or double");
+  static_assert(std::is_same_v<Compact, bfloat16> || std::is_same_v<Compact, float16>, "eFFT compact format must be bfloat16 or float16");
+  static_assert(COMPACT_TOP <= ROOT, "eFFT root must not be compact");
+  static_assert(!std::is_same_v<Compact, float16> || COMPACT_TOP <= 8, "float16 overflows on nodes larger than 128 x 128");
+
+  /**
+   * @brief Check whether the nodes of a level are stored.
+   *
+   * Radix-4 trees store the levels at an even distance from the root, plus the bottom one. When the distance from the
+   * bottom to the root is odd, the first level above the bottom is a radix-2 step.
+   */
+  static constexpr bool stored(const unsigned int level) {
+    return level >= BOTTOM && (RADIX == 2 || level == BOTTOM || (ROOT - level) % 2 == 0);
+  }
+
+  /**
+   * @brief Get the stored level above a stored level.
+   */
+  static constexpr unsigned int up(const unsigned int level) {
+    return (RADIX == 4 && (ROOT - level) % 2 == 0) ? level + 2 : level + 1;
+  }
+
+  static constexpr unsigned int FIRST = BLOCKED ? BOTTOM : up(0); // lowest level recomputed on updates
+
+  /**
+   * @brief Check whether the nodes of a level are stored in the Compact format.
+   */
+  static constexpr bool compact(const unsigned int level) {
+    return level < COMPACT_TOP;
+  }
+
+  /**
+   * @brief log2 of the number of rows of the nodes of a level.
+   */
+  static constexpr unsigned int rowBits(const unsigned int level) {
+    return (H >= W || level > LINES) ? level - (H >= W ? 0 : LINES) : 0;
+  }
+
+  /**
+   * @brief log2 of the number of columns of the nodes of a level.
+   */
+  static constexpr unsigned int colBits(const unsigned int level) {
+    return (W >= H || level > LINES) ? level - (W >= H ? 0 : LINES) : 0;
+  }
+
+  /**
+   * @brief log2 of the number of pixels under a node of a level (the bits of its leaf indices).
+   */
+  static constexpr unsigned int leafBits(const unsigned int level) {
+    return rowBits(level) + colBits(level);
+  }
+
+  /**
+   * @brief Number of nodes of a level.
+   */
+  static constexpr std::size_t nodes(const unsigned int level) {
+    return AREA >> leafBits(level);
+  }
+
+  /**
+   * @brief Number of stored columns of the nodes of a level.
+   */
+  static constexpr unsigned int cols(const unsigned int level) {
+    return (HALF && colBits(level) > 0) ? (1U << (colBits(level) - 1)) + 1 : 1U << colBits(level);
+  }
+
+  /**
+   * @brief Number of elements of the nodes of a level.
+   */
+  static constexpr std::size_t stride(const unsigned int level) {
+    return (std::size_t{1} << rowBits(level)) * cols(level);
+  }
+
+  static constexpr std::array<std::size_t, ROOT + 2> offsets(const bool packed) {
+    std::array<std::size_t, ROOT + 2> offset{};
+    for(unsigned int level = 0; level <= ROOT; level++) {
+      offset[level + 1] = offset[level] + ((stored(level) && compact(level) == packed) ? nodes(level) * stride(level) : 0);
+    }
+    return offset;
+  }
+
+  static constexpr std::array<std::size_t, ROOT + 2> OFFSETS = offsets(false);       // first element of every level
+  static constexpr std::array<std::size_t, ROOT + 2> PACKED_OFFSETS = offsets(true); // same, for the compact levels
+  static constexpr std::size_t ARENA_SIZE = OFFSETS[ROOT + 1];
+  static constexpr std::size_t PACKED_SIZE = PACKED_OFFSETS[ROOT + 1];
+#ifdef EFFT_USE_HUGE_PAGES
+  static constexpr std::size_t ARENA_ALIGNMENT = std::size_t{1} << 21U;
+#else
+  static constexpr std::size_t ARENA_ALIGNMENT = 64;
+#endif
+  static constexpr unsigned int DELTA_MIN_SIZE = 64; // smaller nodes are cheaper to recombine than to patch
+  static constexpr uint32_t NO_BAND = 0xFF;
+  static constexpr unsigned int MEASURE_BLOCK = 8; // child columns combined before their outputs are measured
+
+  struct Run {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t band; // NO_BAND if the bins are in no band
+  };
+  static constexpr unsigned int KEY_BITS = LOG2_W + LOG2_H + 1;
+  static constexpr unsigned int RADIX_BITS = (KEY_BITS + (KEY_BITS + 10) / 11 - 1) / ((KEY_BITS + 10) / 11);
+  static constexpr uint32_t RADIX_MASK = (1U << RADIX_BITS) - 1;
+  static constexpr std::size_t RADIX_SORT_MIN = 256;
+
+  static constexpr uint32_t SNAPSHOT_VERSION = 1;
+  static constexpr std::size_t SNAPSHOT_ALIGNMENT = 4096; // sections start on page boundaries, so they can be mapped
+
+  /**
+   * @brief Header of a snapshot (see save()), followed by the sections at their offsets.
+   */
+  struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t order; // byte order mark
+    uint32_t width;
+    uint32_t height;
+    uint32_t scalar; // sizeof(Scalar)
+    uint32_t half;
+    uint32_t leafBlock;
+    uint32_t radix;
+    uint32_t compactLevels;
+    uint32_t compactFormat; // 0 for bfloat16, 1 for float16
+    uint64_t arena;         // offset of the tree arena
+    uint64_t packed;        // offset of the compact levels
+    uint64_t occupancy;     // offset of the occupancy bitmap
+    uint64_t touched;       // offset of the changed-leaves bitmap
+    uint64_t bytes;         // total size
+  };
+  static_assert(sizeof(SnapshotHeader) == 8 + 10 * sizeof(uint32_t) + 5 * sizeof(uint64_t), "eFFT snapshot header must not be padded");
+
+  static constexpr std::size_t align(const std::size_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+  }
+
+  /**
+   * @brief Get the header of the snapshots of this configuration; snapshots are only loaded into the same configuration.
+   */
+  static constexpr SnapshotHeader snapshotHeader() {
+    const std::size_t words = (AREA + 63) / 64 * sizeof(uint64_t);
+    const std::size_t arena = align(sizeof(SnapshotHeader));
+    const std::size_t packed = align(arena + ARENA_SIZE * sizeof(complex));
+    const std::size_t occupancy = align(packed + 2 * PACKED_SIZE * sizeof(uint16_t));
+    const std::size_t touched = align(occupancy + words);
+    return {{'e', 'F', 'F', 'T', 's', 'n', 'a', 'p'}, SNAPSHOT_VERSION, 0x01020304U, W, H, sizeof(Scalar), HALF, Traits::LEAF_BLOCK, RADIX, Traits::COMPACT_LEVELS, std::is_same_v<Compact, float16> ? 1U : 0U, arena, packed, occupancy, touched, touched + words};
+  }
+
+  struct Section {
+    std::size_t offset;
+    char *data;
+    std::size_t bytes;
+  };
+
+  /**
+   * @brief Get the sections of a snapshot: where they go in the file and where they live in the instance.
+   */
+  [[nodiscard]] std::array<Section, 4> sections() const {
+    constexpr SnapshotHeader header = snapshotHeader();
+    const std::size_t words = occupancy_.size() * sizeof(uint64_t);
+    return {{{header.arena, reinterpret_cast<char *>(tree_.get()), ARENA_SIZE * sizeof(complex)},
+             {header.packed, reinterpret_cast<char *>(const_cast<uint16_t *>(packed_.data())), packed_.size() * sizeof(uint16_t)},
+             {header.occupancy, reinterpret_cast<char *>(const_cast<uint64_t *>(occupancy_.data())), words},
+             {header.touched, reinterpret_cast<char *>(const_cast<uint64_t *>(touched_.data())), words}}};
+  }
+  static_assert(W > 0 && (W & (W - 1)) == 0 && H > 0 && (H & (H - 1)) == 0, "eFFT frame size must be a power of two");
+  static_assert(KEY_BITS <= 32, "eFFT frame size is too large");
+
+  /**
+   * @brief Get the leaf index bits of every row (rows) or column (!rows).
+   *
+   * A node of level l chooses its child with the bits at position leafBits(l-1): the column bit, and the row bit right
+   * above it when both axes split.
+   */
+  template <bool ROWS>
+  static constexpr std::array<uint32_t, ROWS ? H : W> spread() {
+    std::array<uint32_t, ROWS ? H : W> bits{};
+    for(unsigned int level = 1; level <= ROOT; level++) {
+      const unsigned int position = leafBits(level - 1);
+      const bool splitRows = rowBits(level) > rowBits(level - 1);
+      const bool splitCols = colBits(level) > colBits(level - 1);
+      if(ROWS ? !splitRows : !splitCols) {
+        continue;
+      }
+      for(unsigned int i = 0; i < bits.size(); i++) {
+        bits[i] |= ROWS ? ((i >> (LOG2_H - rowBits(level))) & 1U) << (position + (splitCols ? 1U : 0U)) : ((i >> (LOG2_W - colBits(level))) & 1U) << position;
+      }
+    }
+    return bits;
+  }
+
+  static constexpr std::array<uint32_t, H> ROW_SPREAD = spread<true>();  // leaf index bits of every row
+  static constexpr std::array<uint32_t, W> COL_SPREAD = spread<false>(); // leaf index bits of every column
+
+  struct ArenaDeleter {
+    void operator()(complex *p) const { ::operator delete(p, std::align_val_t{ARENA_ALIGNMENT}); }
+  };
+
+  // the tree is recombined by flush(), which lazy instances run from const accessors (under flushMutex_)
+  mutable std::unique_ptr<complex[], ArenaDeleter> tree_;
+  mutable std::vector<uint16_t> packed_; // compact levels, real and imaginary halves interleaved
+  std::unique_ptr<std::mutex> flushMutex_; // lazy mode only
+  const complex *twiddle_{Twiddles<complex, ROOT>::w()};   // shared, see Twiddles
+  const complex *twiddle3_{Twiddles<complex, ROOT>::w3()}; // shared, radix-4 only
+  bool lazy_{false};
+  bool deduplicate_{false};
+  PixelTable pixels_;
+  Propagation propagation_{Propagation::Tree};
+  Eigen::Matrix<complex, Eigen::Dynamic, 1> deltaRows_;
+  Eigen::Matrix<complex, Eigen::Dynamic, 1> deltaCols_;
+  std::unique_ptr<ThreadPool> pool_;
+  unsigned int parallelDepth_{0};
+  unsigned int parallelCombine_{0};
+  std::vector<uint64_t> occupancy_;
+  std::vector<uint64_t> touched_; // leaves changed since the last initialization, see reset()
+  std::vector<uint32_t> keys_;
+  std::vector<uint32_t> sorted_;
+  mutable std::array<std::vector<uint8_t>, ROOT + 1> dirty_;
+  mutable std::array<std::vector<uint32_t>, ROOT + 1> pending_;
+  bool features_{false};                    // derived outputs, see setFeatures()
+  std::size_t bands_{0};
+  std::vector<Run> runs_;                   // runs of root rows in the same band, column by column
+  std::vector<uint32_t> firstRun_;          // first run of every root column, and the end
+  mutable std::vector<Scalar> power_;       // |X|^2 of every root bin, column-major
+  mutable std::vector<double> columnSums_;  // energy of every band, then the total, per root column
+  mutable std::vector<double> bandEnergy_;  // energy of every band, then the total
+#ifdef EFFT_USE_FFTW3
+  fftw_complex *fftwInput_{nullptr};
+  fftw_complex *fftwOutput_{nullptr};
+  fftw_plan plan_{nullptr};
+#endif
+
+  /**
+   * @brief Get a pointer to a node of the tree.
+   *
+   * All the levels live in a single arena. Level l holds the nodes(l) nodes of 2^rowBits(l) x 2^colBits(l) elements
+   * (column-major, 2^l x 2^l in square frames) one after another, so the four children of node k are the contiguous
+   * nodes 4k, ..., 4k+3 of level l-1 (the two children 2k and 2k+1 on the LINES levels of rectangular frames).
+   * Half-spectrum nodes only store their first cols(l) columns. Blocked trees do not store the levels below BOTTOM, and radix-4 trees skip
+   * every other level (see stored()). The compact levels live in a second arena (see packed()).
+   *
+   * @param level Level of the node (0 for the leaves, ROOT for the root).
+   * @param index Index of the node within its level.
+   * @return Pointer to the first element of the node.
+   */
+  [[nodiscard]] inline const complex *node(const unsigned int level, const std::size_t index) const {
+    return tree_.get() + OFFSETS[level] + index * stride(level);
+  }
+
+  /**
+   * @brief Get a pointer to a node of the tree (see node() const).
+   */
+  [[nodiscard]] inline complex *node(const unsigned int level, const std::size_t index) {
+    return writableNode(level, index);
+  }
+
+  /**
+   * @brief Get a writable pointer to a node, for the recombinations that flush() runs on const instances.
+   */
+  [[nodiscard]] inline complex *writableNode(const unsigned int level, const std::size_t index) const {
+    return tree_.get() + OFFSETS[level] + index * stride(level);
+  }
+
+  /**
+   * @brief Get a pointer to a node of a compact level, laid out as in node() with two 16-bit halves per element.
+   *
+   * @param level Level of the node.
+   * @param index Index of the node within its level.
+   * @return Pointer to the real half of the first element of the node.
+   */
+  [[nodiscard]] inline const uint16_t *packed(const unsigned int level, const std::size_t index) const {
+    return packed_.data() + 2 * (PACKED_OFFSETS[level] + index * stride(level));
+  }
+
+  /**
+   * @brief Get a writable pointer to a node of a compact level, for the recombinations that flush() runs on const
+   * instances.
+   */
+  [[nodiscard]] inline uint16_t *writablePacked(const unsigned int level, const std::size_t index) const {
+    return packed_.data() + 2 * (PACKED_OFFSETS[level] + index * stride(level));
+  }
+
+  /**
+   * @brief Get a per-thread buffer of full-precision elements for the compact levels.
+   *
+   * @param slot 0 for decoded children, 1 for the node being combined.
+   * @param size Minimum number of elements.
+   */
+  static complex *scratch(const unsigned int slot, const std::size_t size) {
+    thread_local std::array<std::vector<complex>, 2> buffers;
+    if(buffers[slot].size() < size) {
+      buffers[slot].resize(size);
+    }
+    return buffers[slot].data();
+  }
+
+  /**
+   * @brief Get consecutive nodes of a level in full precision, decoding them if the level is compact.
+   *
+   * @param level Level of the nodes.
+   * @param first Index of the first node.
+   * @param count Number of nodes.
+   * @return Pointer to the first element of the first node.
+   */
+  [[nodiscard]] const complex *load(const unsigned int level, const std::size_t first, const std::size_t count) const {
+    if(!compact(level)) {
+      return node(level, first);
+    }
+    const std::size_t size = count * stride(level);
+    complex *x = scratch(0, size);
+    const uint16_t *h = packed(level, first);
+    if constexpr(std::is_same_v<Scalar, float>) {
+      Compact::decode(h, reinterpret_cast<float *>(x), 2 * size);
+    } else {
+      for(std::size_t k = 0; k < size; k++) {
+        x[k] = complex{Compact::decode(h[2 * k]), Compact::decode(h[2 * k + 1])};
+      }
+    }
+    return x;
+  }
+
+  /**
+   * @brief Get where a node is computed: the node itself, or a per-thread buffer that store() encodes.
+   */
+  [[nodiscard]] complex *target(const unsigned int level, const std::size_t index) const {
+    return compact(level) ? scratch(1, stride(level)) : writableNode(level, index);
+  }
+
+  /**
+   * @brief Encode a node computed by target() if its level is compact.
+   */
+  void store(const unsigned int level, const std::size_t index, const complex *x) const {
+    if(!compact(level)) {
+      return;
+    }
+    uint16_t *h = writablePacked(level, index);
+    if constexpr(std::is_same_v<Scalar, float>) {
+      Compact::encode(reinterpret_cast<const float *>(x), h, 2 * stride(level));
+    } else {
+      for(std::size_t k = 0; k < stride(level); k++) {
+        h[2 * k] = Compact::encode(static_cast<float>(x[k].real()));
+        h[2 * k + 1] = Compact::encode(static_cast<float>(x[k].imag()));
+      }
+    }
+  }
+
+  /**
+   * @brief Write a leaf of a tree with pixel leaves.
+   *
+   * @param index Leaf index.
+   * @param value New value of the pixel.
+   */
+  void write(const std::size_t index, const complex value) {
+    if constexpr(compact(0)) {
+      store(0, index, &value);
+    } else {
+      *node(0, index) = value;
+    }
+  }
+
+  /**
+   * @brief Get the index of the leaf that stores a pixel.
+   *
+   * The leaf index is the bit-reversed row and column interleaved in base 4 (row bit first), followed by the remaining
+   * bit-reversed bits of the longer axis in rectangular frames, i.e. the path that the radix-2 decomposition follows
+   * from the root to the pixel.
+   *
+   * @note Coordinates outside the frame wrap around (only their low bits are used), as in the original recursion.
+   *
+   * @param row Row of the pixel.
+   * @param col Column of the pixel.
+   * @return The leaf index.
+   */
+  [[nodiscard]] inline std::size_t leaf(const unsigned int row, const unsigned int col) const {
+    return static_cast<std::size_t>(ROW_SPREAD[row & (H - 1)]) | COL_SPREAD[col & (W - 1)];
+  }
+
+  /**
+   * @brief Recompute a bottom node of a blocked tree from the occupancy bitmap.
+   *
+   * A 4 x 4 node is the sum of two table lookups. An 8 x 8 node (one bitmap word) is combined from its four 4 x 4
+   * tiles.
+   *
+   * @param index Index of the node within its level.
+   */
+  void tile(const std::size_t index) const {
+    using Tile = LeafTile<HALF, complex>;
+    complex *x = target(BOTTOM, index);
+    if constexpr(BOTTOM == 2) {
+      Tile::run(x, static_cast<uint32_t>(occupancy_[index >> 2U] >> (16U * (index & 3U))));
+    } else {
+      alignas(64) std::array<complex, 4 * Tile::SIZE> children;
+      const uint64_t bits = occupancy_[index];
+      for(unsigned int q = 0; q < 4; q++) {
+        Tile::run(children.data() + q * Tile::SIZE, static_cast<uint32_t>(bits >> (16U * q)));
+      }
+      if constexpr(HALF) {
+        Butterfly::runHalf(x, children.data(), twiddle_ + 8, twiddle_ + 8, 8, 8, 0, 3);
+      } else {
+        Butterfly::run(x, children.data(), twiddle_ + 8, twiddle_ + 8, 8, 8, 0, 4);
+      }
+    }
+    store(BOTTOM, index, x);
+  }
+
+  /**
+   * @brief Recompute a node from its four children (or from the bitmap at the bottom of a blocked tree).
+   *
+   * @param level Level of the node.
+   * @param index Index of the node within its level.
+   */
+  void combine(const unsigned int level, const std::size_t index) const {
+    if constexpr(BLOCKED) {
+      if(level == BOTTOM) {
+        tile(index);
+        if(features_ && level == ROOT) {
+          measure();
+        }
+        return;
+      }
+    }
+    const unsigned int n = 1U << level;
+    const bool root = features_ && level == ROOT; // the root butterflies measure the columns they write
+    complex *x = target(level, index);
+    const complex *w = twiddle_ + n;
+    if(RADIX == 4 && level >= BOTTOM + 2) {
+      const complex *grandchildren = load(level - 2, index << 4U, 16);
+      const complex *w2 = twiddle_ + (n >> 1U);
+      const complex *w3 = twiddle3_ + (n >> 2U);
+      sweep(n, level - 2, n >> 2U, [this, root, x, grandchildren, w, w2, w3, n](const unsigned int j0, const unsigned int j1) {
+        if(!root) {
+          Butterfly4::run(x, grandchildren, w, w2, w3, n, j0, j1);
+          return;
+        }
+        for(unsigned int b0 = j0; b0 < j1; b0 += MEASURE_BLOCK) {
+          const unsigned int b1 = std::min(b0 + MEASURE_BLOCK, j1);
+          Butterfly4::run(x, grandchildren, w, w2, w3, n, b0, b1);
+          for(unsigned int j = b0; j < b1; j++) {
+            for(unsigned int b = 0; b < 4; b++) {
+              measure(x, j + b * (n >> 2U));
+            }
+          }
+        }
+      });
+    } else if(level <= LINES) { // only the longer axis is split
+      const complex *children = load(level - 1, index << 1U, 2);
+      constexpr bool HALF_LINE = HALF && W > H;
+      constexpr auto kernel = HALF_LINE ? Butterfly::lineHalf<complex> : Butterfly::line<complex>;
+      sweep(n, level - 1, HALF_LINE ? (n >> 2U) + 1 : n >> 1U, [x, children, w, n](const unsigned int j0, const unsigned int j1) {
+        kernel(x, children, w, n, j0, j1);
+      });
+      if(root) { // a single row or column
+        for(unsigned int c = 0; c < cols(ROOT); c++) {
+          measure(x, c);
+        }
+      }
+    } else {
+      const complex *children = load(level - 1, index << 2U, 4);
+      const unsigned int rows = 1U << rowBits(level), columns = 1U << colBits(level);
+      const complex *wr = twiddle_ + rows;
+      const complex *wc = twiddle_ + columns;
+      constexpr auto kernel = HALF ? Butterfly::runHalf<complex> : Butterfly::run<complex>;
+      sweep(n, level - 1, HALF ? (columns >> 2U) + 1 : columns >> 1U, [this, root, x, children, wr, wc, rows, columns](const unsigned int j0, const unsigned int j1) {
+        if(!root) {
+          kernel(x, children, wr, wc, rows, columns, j0, j1);
+          return;
+        }
+        const unsigned int mdiv2 = columns >> 1U;
+        for(unsigned int b0 = j0; b0 < j1; b0 += MEASURE_BLOCK) {
+          const unsigned int b1 = std::min(b0 + MEASURE_BLOCK, j1);
+          kernel(x, children, wr, wc, rows, columns, b0, b1);
+          for(unsigned int j = b0; j < b1; j++) {
+            measure(x, j);
+            if(!HALF) {
+              measure(x, j + mdiv2);
+            } else if(j == 0) {
+              measure(x, mdiv2);
+            } else if(2 * j < mdiv2) { // mirrored column
+              measure(x, mdiv2 - j);
+            }
+          }
+        }
+      });
+    }
+    store(level, index, x);
+    if(root) {
+      total();
+    }
+  }
+
+  /**
+   * @brief Refresh the derived outputs of a root column: its power, then its energy per band, run by run.
+   * @note In half spectra, the columns other than 0 and W/2 also stand for their conjugate columns, so their energy
+   * counts twice.
+   *
+   * @param x The root.
+   * @param c Column index.
+   */
+  void measure(const complex *x, const unsigned int c) const {
+    const std::size_t offset = static_cast<std::size_t>(c) * H;
+    const complex *bins = x + offset;
+    Scalar *power = power_.data() + offset;
+    for(unsigned int i = 0; i < H; i++) {
+      power[i] = std::norm(bins[i]);
+    }
+    double *sums = columnSums_.data() + static_cast<std::size_t>(c) * (bands_ + 1);
+    std::fill_n(sums, bands_ + 1, 0.0);
+    const double weight = (HALF && c != 0 && 2 * c != W) ? 2.0 : 1.0;
+    for(uint32_t r = firstRun_[c]; r < firstRun_[c + 1]; r++) {
+      const Run &run = runs_[r];
+      double sum = 0;
+      for(uint32_t i = run.begin; i < run.end; i++) {
+        sum += power[i];
+      }
+      sums[bands_] += weight * sum;
+      if(run.band != NO_BAND) {
+        sums[run.band] += weight * sum;
+      }
+    }
+  }
+
+  /**
+   * @brief Refresh all the derived outputs in a separate pass, for the root changes that do not go through combine().
+   */
+  void measure() const {
+    if(!features_) {
+      return;
+    }
+    for(unsigned int c = 0; c < cols(ROOT); c++) {
+      measure(node(ROOT, 0), c);
+    }
+    total();
+  }
+
+  /**
+   * @brief Zero the derived outputs, for an empty frame.
+   */
+  void clearFeatures() {
+    std::fill(power_.begin(), power_.end(), Scalar{0});
+    std::fill(columnSums_.begin(), columnSums_.end(), 0.0);
+    std::fill(bandEnergy_.begin(), bandEnergy_.end(), 0.0);
+  }
+
+  /**
+   * @brief Add up the energies of the root columns.
+   */
+  void total() const {
+    std::fill(bandEnergy_.begin(), bandEnergy_.end(), 0.0);
+    for(unsigned int c = 0; c < cols(ROOT); c++) {
+      const double *sums = columnSums_.data() + static_cast<std::size_t>(c) * (bands_ + 1);
+      for(std::size_t b = 0; b <= bands_; b++) {
+        bandEnergy_[b] += sums[b];
+      }
+    }
+  }
+
+  /**
+   * @brief Run a kernel over the child columns of a node, split across the pool if the node is large enough.
+   *
+   * @note Nodes whose children are compact are never split: they are combined in the per-thread scratch() buffers, and
+   * a thread waiting for the chunks may run another subtree update that reuses them.
+   *
+   * @param n Size of the node (its longer side).
+   * @param below Level of the children the kernel reads.
+   * @param columns Number of child columns.
+   * @param f The kernel, invoked with the bounds of each range of columns.
+   */
+  template <typename F>
+  void sweep(const unsigned int n, const unsigned int below, const unsigned int columns, const F &f) const {
+    if(pool_ && parallelCombine_ && n >= parallelCombine_ && !compact(below)) {
+      pool_->parallelFor(0, columns, [&f](const std::size_t j0, const std::size_t j1) {
+        f(static_cast<unsigned int>(j0), static_cast<unsigned int>(j1));
+      });
+    } else {
+      f(0, columns);
+    }
+  }
+
+  /**
+   * @brief Mark a node to be recombined by the next flush().
+   *
+   * @param level Level of the node.
+   * @param index Index of the node within its level.
+   * @return False if the node was already dirty (and so are its ancestors), true otherwise.
+   */
+  bool markDirty(const unsigned int level, const std::size_t index) {
+    if(dirty_[level][index]) {
+      return false;
+    }
+    dirty_[level][index] = 1;
+    pending_[level].push_back(static_cast<uint32_t>(index));
+    return true;
+  }
+
+  /**
+   * @brief Add the spectrum of a single pixel to every ancestor of its leaf.
+   *
+   * At level l the nodes have n x m elements and the pixel sits at (r, c) = (row >> (LOG2_H - log2 n), col >> (LOG2_W -
+   * log2 m)) of the decimated sub-image, so the node changes by sign * exp(-2πi(ur/n+vc/m)). This is the outer product
+   * of two twiddle vectors, applied without reading the siblings. Nodes smaller than DELTA_MIN_SIZE x DELTA_MIN_SIZE
+   * and compact nodes are recombined as usual.
+   *
+   * @param p The stimulus that flipped its pixel.
+   * @param index Index of the leaf of the pixel.
+   */
+  void propagateDelta(const Stimulus &p, std::size_t index) {
+    const complex sign{p.state ? Scalar{1} : Scalar{-1}, 0};
+    for(unsigned int level = FIRST, below = 0; level <= ROOT; below = level, level = up(level)) {
+      index >>= leafBits(level) - leafBits(below);
+      const unsigned int n = 1U << rowBits(level), m = 1U << colBits(level);
+      if(n * m < DELTA_MIN_SIZE * DELTA_MIN_SIZE || compact(level)) {
+        combine(level, index);
+        continue;
+      }
+      const unsigned int r = p.row >> (LOG2_H - rowBits(level));
+      const unsigned int c = p.col >> (LOG2_W - colBits(level));
+      const complex *wr = twiddle_ + n;
+      const complex *wc = twiddle_ + m;
+      for(unsigned int k = 0; k < n; k++) {
+        deltaRows_[k] = sign * wr[(r * k) & (n - 1)];
+      }
+      for(unsigned int k = 0; k < cols(level); k++) {
+        deltaCols_[k] = wc[(c * k) & (m - 1)];
+      }
+      Eigen::Map<matrix>(node(level, index), n, cols(level)).noalias() += deltaRows_.head(n) * deltaCols_.head(cols(level)).transpose();
+      if(level == ROOT) {
+        measure();
+      }
+    }
+  }
+
+  /**
+   * @brief Forget the pending recombinations (the nodes are about to be rewritten).
+   */
+  void discard() {
+    for(unsigned int level = FIRST; level <= ROOT; level = up(level)) {
+      for(const uint32_t index : pending_[level]) {
+        dirty_[level][index] = 0;
+      }
+      pending_[level].clear();
+    }
+  }
+
+  /**
+   * @brief Sets the occupancy of a leaf.
+   *
+   * @param index Leaf index.
+   * @param state New state of the leaf.
+   * @return True if the occupancy changed, false otherwise.
+   */
+  bool occupy(const std::size_t index, const bool state) {
+    uint64_t &word = occupancy_[index >> 6U];
+    const uint64_t bit = uint64_t{1} << (index & 63U);
+    if(static_cast<bool>(word & bit) == state) {
+      return false;
+    }
+    word ^= bit;
+    touched_[index >> 6U] |= bit;
+    return true;
+  }
+
+  /**
+   * @brief Sort the packet keys.
+   *
+   * Keys are sorted with a least-significant-digit radix sort over the KEY_BITS bits they use, falling back to
+   * std::sort for small packets.
+   *
+   * @param count Number of keys.
+   * @return Pointer to the sorted keys.
+   */
+  uint32_t *sort(const std::size_t count) {
+    if(count < RADIX_SORT_MIN) {
+      std::sort(keys_.begin(), keys_.begin() + static_cast<std::ptrdiff_t>(count));
+      return keys_.data();
+    }
+    sorted_.resize(count);
+    uint32_t *src = keys_.data();
+    uint32_t *dst = sorted_.data();
+    std::array<uint32_t, (1U << RADIX_BITS) + 1> offsets;
+    for(unsigned int shift = 0; shift < KEY_BITS; shift += RADIX_BITS) {
+      offsets.fill(0);
+      for(std::size_t i = 0; i < count; i++) {
+        offsets[((src[i] >> shift) & RADIX_MASK) + 1]++;
+      }
+      for(std::size_t d = 1; d < offsets.size(); d++) {
+        offsets[d] += offsets[d - 1];
+      }
+      for(std::size_t i = 0; i < count; i++) {
+        dst[offsets[(src[i] >> shift) & RADIX_MASK]++] = src[i];
+      }
+      std::swap(src, dst);
+    }
+    return src;
+  }
+
+  /**
+   * @brief Updates a subtree with multiple stimuli.
+   *
+   * The stimuli are given as sorted keys (leaf index and state), one per changed leaf, so the stimuli of every subtree
+   * form a contiguous range whose bounds are found by binary search.
+   *
+   * @param level Level of the subtree root.
+   * @param index Index of the subtree root within its level.
+   * @param b0 Pointer to the first key of the subtree.
+   * @param e0 Pointer past the last key of the subtree.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const unsigned int level, const std::size_t index, const uint32_t *b0, const uint32_t *e0) {
+    if(level == BOTTOM) { // keys only hold stimuli that change their leaf, whose bits are already set
+      if constexpr(BLOCKED) {
+        if(lazy_) {
+          markDirty(level, index);
+        } else {
+          combine(level, index);
+        }
+      } else {
+        write(index, complex{static_cast<Scalar>(b0[0] & 1U), 0});
+      }
+      return true;
+    }
+
+    const unsigned int below = (RADIX == 4 && level >= BOTTOM + 2) ? level - 2 : level - 1;
+    const unsigned int fanout = 1U << (leafBits(level) - leafBits(below));
+    const std::size_t child = index << (leafBits(level) - leafBits(below));
+    const unsigned int shift = leafBits(below) + 1;
+    std::array<const uint32_t *, 17> bounds{};
+    bounds[0] = b0;
+    bounds[fanout] = e0;
+    for(unsigned int q = 1; q < fanout; q++) {
+      bounds[q] = std::lower_bound(bounds[q - 1], e0, static_cast<uint32_t>((child + q) << shift));
+    }
+
+    bool changed = false;
+    if(pool_ && !lazy_ && ROOT - level < parallelDepth_) {
+      std::array<bool, 16> changes{};
+      ThreadPool::TaskGroup group(*pool_);
+      for(unsigned int q = 1; q < fanout; q++) {
+        if(bounds[q] != bounds[q + 1]) {
+          group.run([&, q] { changes[q] = update(below, child + q, bounds[q], bounds[q + 1]); });
+        }
+      }
+      if(bounds[0] != bounds[1]) {
+        changes[0] = update(below, child, bounds[0], bounds[1]);
+      }
+      group.wait();
+      changed = std::any_of(changes.begin(), changes.end(), [](const bool c) { return c; });
+    } else {
+      for(unsigned int q = 0; q < fanout; q++) {
+        if(bounds[q] != bounds[q + 1]) {
+          changed = update(below, child + q, bounds[q], bounds[q + 1]) || changed;
+        }
+      }
+    }
+
+    if(changed) {
+      if(lazy_) {
+        markDirty(level, index);
+      } else {
+        combine(level, index);
+      }
+    }
+    return changed;
+  }
+
+public:
+  eFFT() {
+    tree_.reset(static_cast<complex *>(::operator new(ARENA_SIZE * sizeof(complex), std::align_val_t{ARENA_ALIGNMENT})));
+#if defined(EFFT_USE_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+    madvise(tree_.get(), ARENA_SIZE * sizeof(complex), MADV_HUGEPAGE);
+#endif
+    std::fill_n(tree_.get(), ARENA_SIZE, complex{0, 0});
+    packed_.assign(2 * PACKED_SIZE, 0);
+#ifdef EFFT_USE_FFTW3
+    fftwInput_ = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * AREA));
+    fftwOutput_ = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * AREA));
+    if(!fftwInput_ || !fftwOutput_) throw std::bad_alloc();
+#endif
+    deltaRows_.resize(H);
+    deltaCols_.resize(W);
+    occupancy_.assign((AREA + 63) / 64, 0);
+    touched_.assign((AREA + 63) / 64, 0);
+  }
+
+  ~eFFT() {
+#ifdef EFFT_USE_FFTW3
+    if(plan_) fftw_destroy_plan(plan_);
+    if(fftwInput_) fftw_free(fftwInput_);
+    if(fftwOutput_) fftw_free(fftwOutput_);
+#endif
+  }
+
+  eFFT(const eFFT &) = delete;
+  eFFT(eFFT &&) noexcept = default;
+  eFFT &operator=(const eFFT &) = delete;
+  eFFT &operator=(eFFT &&) noexcept = default;
+
+  /**
+   * @brief Get the frame size of the FFT.
+   * @note Only square frames have a single size; see width() and height().
+   * @return The frame size as an unsigned integer.
+   */
+  [[nodiscard]] constexpr unsigned int framesize() const {
+    static_assert(W == H, "eFFT framesize() needs a square frame");
+    return W;
+  }
+
+  /**
+   * @brief Get the width (number of columns) of the frame.
+   * @return The width as an unsigned integer.
+   */
+  [[nodiscard]] constexpr unsigned int width() const {
+    return W;
+  }
+
+  /**
+   * @brief Get the height (number of rows) of the frame.
+   * @return The height as an unsigned integer.
+   */
+  [[nodiscard]] constexpr unsigned int height() const {
+    return H;
+  }
+
+  /**
+   * @brief Get the memory owned by this instance: the tree, the occupancy bitmap and the derived outputs.
+   * @note The twiddle factors and leaf tables are shared by all the instances; see sharedFootprint().
+   * @return The footprint in bytes.
+   */
+  [[nodiscard]] std::size_t footprint() const {
+    return ARENA_SIZE * sizeof(complex) + packed_.size() * sizeof(uint16_t) + occupancy_.size() * sizeof(uint64_t) + runs_.size() * sizeof(Run) + firstRun_.size() * sizeof(uint32_t) + power_.size() * sizeof(Scalar) + columnSums_.size() * sizeof(double);
+  }
+
+  /**
+   * @brief Get the memory shared by all the instances of this size: the twiddle factors and leaf tables.
+   * @return The footprint in bytes.
+   */
+  [[nodiscard]] static constexpr std::size_t sharedFootprint() {
+    return Twiddles<complex, ROOT>::footprint() + (W + H) * sizeof(uint32_t);
+  }
+
+  /**
+   * @brief Enable or disable lazy propagation.
+   *
+   * In lazy mode, updates only write the leaves and mark their ancestors as dirty. The dirty nodes are recombined
+   * exactly once, bottom-up, by the next call to flush() or getFFT(). Disabling lazy mode flushes the pending work.
+   *
+   * @param lazy True to defer the propagation, false to propagate on every update.
+   */
+  void setLazy(const bool lazy) {
+    if(lazy && !lazy_) {
+      if(!flushMutex_) {
+        flushMutex_ = std::make_unique<std::mutex>();
+      }
+      for(unsigned int level = FIRST; level <= ROOT; level = up(level)) {
+        dirty_[level].assign(nodes(level), 0);
+        pending_[level].reserve(nodes(level));
+      }
+    } else if(!lazy && lazy_) {
+      flush();
+    }
+    lazy_ = lazy;
+  }
+
+  /**
+   * @brief Check whether lazy propagation is enabled.
+   * @return True in lazy mode, false otherwise.
+   */
+  [[nodiscard]] bool lazy() const {
+    return lazy_;
+  }
+
+  /**
+   * @brief Enable or disable the deduplication pre-pass of packet updates.
+   *
+   * When enabled, repeated pixels of a packet are collapsed into a single stimulus before sorting, preferring state true
+   * over false as Stimuli::filter() does. The result is the same either way; the pre-pass pays off on packets with
+   * many repeated pixels.
+   *
+   * @param deduplicate True to collapse repeated pixels, false to route every stimulus.
+   */
+  void setDeduplicate(const bool deduplicate) {
+    deduplicate_ = deduplicate;
+  }
+
+  /**
+   * @brief Select how single stimuli are propagated to the root.
+   *
+   * Propagation::Delta applies a rank-1 update to each ancestor instead of recomputing its butterflies, so it only
+   * touches the nodes on the path. The error of the rank-1 updates accumulates over time; initialize(const cfloatmat &)
+   * rebuilds the tree from scratch. Packets and lazy updates always recombine the nodes from their children.
+   *
+   * @param propagation The propagation strategy.
+   */
+  void setPropagation(const Propagation propagation) {
+    propagation_ = propagation;
+  }
+
+  /**
+   * @brief Get the propagation strategy for single stimuli.
+   * @return The propagation strategy.
+   */
+  [[nodiscard]] Propagation propagation() const {
+    return propagation_;
+  }
+
+  /**
+   * @brief Run packet updates and initialization on several threads.
+   *
+   * The packet update recurses into the four quadrant subtrees concurrently for the top `depth` levels of the tree,
+   * and initialize(const cfloatmat &) recombines the nodes of each level in parallel. Both share a work-stealing pool.
+   * Lazy packet updates stay sequential.
+   *
+   * @param threads Number of threads, including the calling one. Use 1 to disable multithreading.
+   * @param depth Number of levels, counting from the root, whose subtrees are updated concurrently.
+   */
+  void setThreads(const unsigned int threads, const unsigned int depth = 2) {
+    pool_.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+    parallelDepth_ = depth;
+  }
+
+  /**
+   * @brief Split the butterflies of large nodes across the threads.
+   *
+   * Nodes of at least size x size are recombined by splitting their columns across the pool created by setThreads(),
+   * which cuts the latency of single updates on large frames. Smaller nodes, and nodes combined from compact levels
+   * (see eFFTTraits::COMPACT_LEVELS), keep running on the calling thread.
+   *
+   * @param size Minimum node size to split, or 0 to disable.
+   */
+  void setParallelCombine(const unsigned int size) {
+    parallelCombine_ = size;
+  }
+
+  /**
+   * @brief Get the number of threads used by packet updates and initialization.
+   * @return The number of threads, including the calling one.
+   */
+  [[nodiscard]] unsigned int threads() const {
+    return pool_ ? pool_->size() : 1;
+  }
+
+  /**
+   * @brief Recombine the nodes left dirty by lazy updates.
+   * @note This is a no-op unless lazy mode is enabled. It is called by getFFT() and the other const accessors, so in
+   * lazy mode they modify the tree; concurrent flushes are serialized by a mutex, so const accessors may be called from
+   * several threads, but never concurrently with an update.
+   */
+  void flush() const {
+    if(!lazy_) {
+      return;
+    }
+    const std::lock_guard<std::mutex> lock(*flushMutex_);
+    for(unsigned int level = FIRST; level <= ROOT; level = up(level)) {
+      for(const uint32_t index : pending_[level]) {
+        combine(level, index);
+        dirty_[level][index] = 0;
+      }
+      pending_[level].clear();
+    }
+  }
+
+  /**
+   * @brief Initializes the FFT computation with zero matrix.
+   */
+  void initialize() {
+    discard();
+    std::fill_n(tree_.get(), ARENA_SIZE, complex{0, 0});
+    std::fill(packed_.begin(), packed_.end(), 0);
+    std::fill(occupancy_.begin(), occupancy_.end(), 0);
+    std::fill(touched_.begin(), touched_.end(), 0);
+    clearFeatures();
+  }
+
+  /**
+   * @brief Clears the FFT in place, only rewriting the nodes above the pixels changed since the last initialization.
+   *
+   * Same result as initialize(), but the changed leaves are tracked in a bitmap, so the cost is one pass over the bitmap
+   * plus the zeroing of their ancestors instead of the whole tree. The bitmap is scanned in leaf order, so the ancestors
+   * of every level come in order and each of them is cleared once. Nothing is allocated, so instances can be reused
+   * between recordings.
+   */
+  void reset() {
+    discard();
+    std::array<std::size_t, ROOT + 1> cleared;
+    cleared.fill(~std::size_t{0});
+    for(std::size_t word = 0; word < touched_.size(); word++) {
+      if(touched_[word] == 0) {
+        continue;
+      }
+      for(uint64_t bits = touched_[word]; bits != 0; bits &= bits - 1) {
+        std::size_t index = (word << 6U) | ctz64(bits);
+        if constexpr(!BLOCKED) {
+          write(index, complex{0, 0});
+        }
+        for(unsigned int level = FIRST, below = 0; level <= ROOT; below = level, level = up(level)) {
+          index >>= leafBits(level) - leafBits(below);
+          if(cleared[level] == index) {
+            break;
+          }
+          cleared[level] = index;
+          if(compact(level)) {
+            std::fill_n(writablePacked(level, index), 2 * stride(level), 0);
+          } else {
+            std::fill_n(node(level, index), stride(level), complex{0, 0});
+          }
+        }
+      }
+      occupancy_[word] = 0;
+      touched_[word] = 0;
+    }
+    clearFeatures();
+  }
+
+  /**
+   * @brief Initializes the FFT computation with the provided matrix.
+   * @note Stimuli are compared against the occupancy of the pixels, so the matrix is expected to be binary: any non-zero
+   * pixel counts as 'on'. Blocked trees (Traits::LEAF_BLOCK > 1) only keep the occupancy, so they binarize it.
+   *
+   * @param x Input H x W matrix.
+   */
+  void initialize(const cfloatmat &x) {
+    discard();
+    std::fill(occupancy_.begin(), occupancy_.end(), 0);
+    std::fill(touched_.begin(), touched_.end(), 0);
+    for(unsigned int j = 0; j < W; j++) {
+      for(unsigned int i = 0; i < H; i++) {
+        const std::size_t index = leaf(i, j);
+        if constexpr(!BLOCKED) {
+          write(index, static_cast<complex>(x(i, j)));
+        }
+        occupy(index, x(i, j) != cfloat{0.0F, 0.0F});
+      }
+    }
+    for(unsigned int level = FIRST; level <= ROOT; level = up(level)) {
+      const std::size_t count = nodes(level);
+      const auto run = [this, level](const std::size_t first, const std::size_t last) {
+        for(std::size_t index = first; index < last; index++) {
+          combine(level, index);
+        }
+      };
+      if(pool_) {
+        pool_->parallelFor(0, count, run);
+      } else {
+        run(0, count);
+      }
+    }
+  }
+
+  /**
+   * @brief Updates the FFT with a single stimulus.
+   *
+   * Stimuli that do not change the state of their pixel are rejected by the occupancy bitmap without touching the tree.
+   *
+   * @param p The stimulus to update.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const Stimulus &p) {
+    std::size_t index = leaf(p.row, p.col);
+    if(!occupy(index, p.state)) {
+      return false;
+    }
+    if constexpr(!BLOCKED) {
+      write(index, complex{static_cast<Scalar>(p.state), 0});
+    }
+    if(!lazy_ && propagation_ == Propagation::Delta) {
+      propagateDelta(p, index);
+      return true;
+    }
+    for(unsigned int level = FIRST, below = 0; level <= ROOT; below = level, level = up(level)) {
+      index >>= leafBits(level) - leafBits(below);
+      if(!lazy_) {
+        combine(level, index);
+      } else if(!markDirty(level, index)) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Updates the FFT with multiple stimuli.
+   *
+   * The packet is routed through the tree in a single pass: every stimulus gets a key made of its leaf index (the
+   * bit-reversed, interleaved row and column) and its state, and the keys are radix-sorted once, so the stimuli of each
+   * subtree are contiguous. Stimuli that leave their pixel unchanged are dropped against the occupancy bitmap before the
+   * tree is touched, so unchanged subtrees are skipped entirely. The keys live in internal buffers that are reused across calls, so the stimuli are not
+   * modified, the same packet can be fed to several instances and the steady state does not allocate.
+   *
+   * @param pv Pointer to the first stimulus.
+   * @param count Number of stimuli.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const Stimulus *pv, const std::size_t count) {
+    if(count == 0) {
+      return false;
+    }
+    keys_.resize(count);
+    std::size_t unique = 0;
+    if(deduplicate_) {
+      pixels_.reset(AREA);
+      for(std::size_t i = 0; i < count; i++) {
+        const auto [slot, inserted] = pixels_.emplace((pv[i].row & (H - 1)) * W + (pv[i].col & (W - 1)), static_cast<uint32_t>(unique));
+        if(inserted) {
+          keys_[unique++] = static_cast<uint32_t>(leaf(pv[i].row, pv[i].col) << 1U) | static_cast<uint32_t>(pv[i].state);
+        } else {
+          keys_[slot] |= static_cast<uint32_t>(pv[i].state);
+        }
+      }
+    } else {
+      for(std::size_t i = 0; i < count; i++) {
+        const std::size_t index = leaf(pv[i].row, pv[i].col);
+        if(pv[i].state || static_cast<bool>((occupancy_[index >> 6U] >> (index & 63U)) & 1U)) { // 'off' on an 'off' pixel is a no-op
+          keys_[unique++] = static_cast<uint32_t>(index << 1U) | static_cast<uint32_t>(pv[i].state);
+        }
+      }
+    }
+    uint32_t *keys = sort(unique);
+
+    // keep one key per leaf, the last one so that 'on' wins, and only if it changes the leaf
+    std::size_t changes = 0;
+    for(std::size_t i = 0; i < unique; i++) {
+      if(i + 1 < unique && (keys[i] >> 1U) == (keys[i + 1] >> 1U)) {
+        continue;
+      }
+      if(occupy(keys[i] >> 1U, static_cast<bool>(keys[i] & 1U))) {
+        keys[changes++] = keys[i];
+      }
+    }
+    return changes != 0 && update(ROOT, 0, keys, keys + changes);
+  }
+
+  /**
+   * @brief Updates the FFT with multiple stimuli.
+   *
+   * @param pv The stimuli to update.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const Stimuli &pv) { return update(pv.data(), pv.size()); }
+
+  /**
+   * @brief Save the state of the transform (the tree, the compact levels and the occupancy) as a snapshot.
+   *
+   * A snapshot is a versioned header followed by the raw sections, each starting on a 4096-byte boundary, so saving and
+   * loading are plain copies of the arena. Snapshots are only compatible with the same frame size, traits and byte
+   * order. In lazy mode, the pending updates are flushed first.
+   *
+   * @param os Output stream, opened in binary mode.
+   * @return True on success, false if the stream failed.
+   */
+  bool save(std::ostream &os) const {
+    flush();
+    constexpr SnapshotHeader header = snapshotHeader();
+    constexpr std::array<char, 64> zeros{};
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::size_t position = sizeof(header);
+    for(const Section &section : sections()) {
+      while(position < section.offset) {
+        const std::size_t count = std::min(zeros.size(), section.offset - position);
+        os.write(zeros.data(), static_cast<std::streamsize>(count));
+        position += count;
+      }
+      os.write(section.data, static_cast<std::streamsize>(section.bytes));
+      position += section.bytes;
+    }
+    return static_cast<bool>(os);
+  }
+
+  /**
+   * @brief Save a snapshot to a file (see save(std::ostream &)).
+   *
+   * @param path File path.
+   * @return True on success, false otherwise.
+   */
+  bool save(const std::string &path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    return save(os) && os.flush();
+  }
+
+  /**
+   * @brief Load a snapshot written by save().
+   * @note On failure after the header was accepted, the transform is left cleared as by initialize().
+   *
+   * @param is Input stream, opened in binary mode.
+   * @return True on success, false if the stream failed or the snapshot belongs to another configuration.
+   */
+  bool load(std::istream &is) {
+    constexpr SnapshotHeader expected = snapshotHeader();
+    SnapshotHeader header{};
+    if(!is.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(&header, &expected, sizeof(header)) != 0) {
+      return false;
+    }
+    discard();
+    std::size_t position = sizeof(header);
+    for(const Section &section : sections()) {
+      is.ignore(static_cast<std::streamsize>(section.offset - position));
+      is.read(section.data, static_cast<std::streamsize>(section.bytes));
+      position = section.offset + section.bytes;
+    }
+    if(!is) {
+      initialize();
+      return false;
+    }
+    measure();
+    return true;
+  }
+
+  /**
+   * @brief Load a snapshot from a file (see load(std::istream &)).
+   *
+   * @param path File path.
+   * @return True on success, false otherwise.
+   */
+  bool load(const std::string &path) {
+    std::ifstream is(path, std::ios::binary);
+    return is && load(is);
+  }
+
+  /**
+   * @brief Load a snapshot from memory, e.g. a memory-mapped file, with one copy per section.
+   *
+   * @param data Pointer to the snapshot.
+   * @param size Size of the snapshot in bytes.
+   * @return True on success, false if the snapshot is truncated or belongs to another configuration.
+   */
+  bool load(const void *data, const std::size_t size) {
+    constexpr SnapshotHeader expected = snapshotHeader();
+    if(size < expected.bytes || std::memcmp(data, &expected, sizeof(expected)) != 0) {
+      return false;
+    }
+    discard();
+    for(const Section &section : sections()) {
+      std::memcpy(section.data, static_cast<const char *>(data) + section.offset, section.bytes);
+    }
+    measure();
+    return true;
+  }
+
+  /**
+   * @brief Get the size of the snapshots of this configuration.
+   * @return The size in bytes.
+   */
+  [[nodiscard]] static constexpr std::size_t snapshotSize() {
+    return snapshotHeader().bytes;
+  }
+
+#ifdef EFFT_USE_FFTW3
+  /**
+   * @brief Initialize the FFT ground truth (FFTW) using the given image.
+   *
+   * @param image A complex float matrix to initialize the FFT input. Defaults to a zero matrix.
+   */
+  void initializeGroundTruth(const cfloatmat &image = cfloatmat::Zero(H, W)) {
+    plan_ = fftw_plan_dft_2d(H, W, fftwInput_, fftwOutput_, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED | FFTW_NO_SIMD | FFTW_PRESERVE_INPUT);
+    for(Eigen::Index i = 0; i < image.rows(); i++) {
+      for(Eigen::Index j = 0; j < image.cols(); j++) {
+        fftwInput_[W * i + j][0] = image(i, j).real();
+        fftwInput_[W * i + j][1] = image(i, j).imag();
+      }
+    }
+    fftw_execute(plan_);
+  }
+
+  /**
+   * @brief Update the FFT ground truth (FFTW) with a single stimulus.
+   *
+   * @param p The stimulus to update.
+   */
+  void updateGroundTruth(const Stimulus &p) {
+    fftwInput_[W * p.row + p.col][0] = static_cast<double>(p.state);
+    fftwInput_[W * p.row + p.col][1] = 0;
+    fftw_execute(plan_);
+  }
+
+  /**
+   * @brief Update the FFT ground truth (FFTW) with multiple stimuli.
+   *
+   * @param pv The stimuli to update.
+   */
+  void updateGroundTruth(const Stimuli &pv) {
+    std::set<std::pair<unsigned int, unsigned int>> activated;
+    for(const Stimulus &p : pv) {
+      if(p.state) {
+        activated.insert({p.row, p.col});
+      } else if(activated.find({p.row, p.col}) != activated.end()) {
+        continue;
+      }
+      fftwInput_[W * p.row + p.col][0] = static_cast<double>(p.state);
+      fftwInput_[W * p.row + p.col][1] = 0;
+    }
+    fftw_execute(plan_);
+  }
+#endif
+
+  /**
+   * @brief Get the FFT result as an Eigen matrix of complex Traits::Scalar (complex floats by default).
+   * @note In lazy mode, this flushes the pending updates first (see flush() for thread safety). The view is invalidated
+   * by the next update.
+   * @note The result is H x W; with eFFTHalfSpectrumTraits, it is the H x (W/2+1) half spectrum; use getFullFFT() to
+   * expand it.
+   *
+   * @return The FFT result.
+   */
+  [[nodiscard]] inline Eigen::Map<const matrix> getFFT() const {
+    flush();
+    return {node(ROOT, 0), H, cols(ROOT)};
+  }
+
+  /**
+   * @brief Get the full H x W FFT result, expanding the half spectrum by conjugate symmetry if needed.
+   *
+   * @return The FFT result.
+   */
+  [[nodiscard]] matrix getFullFFT() const {
+    const Eigen::Map<const matrix> x = getFFT();
+    if constexpr(!HALF) {
+      return x;
+    }
+    matrix full(H, W);
+    full.leftCols(cols(ROOT)) = x;
+    for(unsigned int v = cols(ROOT); v < W; v++) {
+      for(unsigned int u = 0; u < H; u++) {
+        full(u, v) = std::conj(x((H - u) % H, W - v));
+      }
+    }
+    return full;
+  }
+
+  /**
+   * @brief Get a single bin of the FFT.
+   * @note With eFFTHalfSpectrumTraits, the bins of the columns that are not stored are obtained by conjugate symmetry.
+   *
+   * @param u Row frequency, lower than H.
+   * @param v Column frequency, lower than W.
+   * @return The FFT bin (u, v).
+   */
+  [[nodiscard]] complex bin(const unsigned int u, const unsigned int v) const {
+    const Eigen::Map<const matrix> x = getFFT();
+    if(HALF && v >= cols(ROOT)) {
+      return std::conj(x((H - u) % H, W - v));
+    }
+    return x(u, v);
+  }
+
+  /**
+   * @brief Get a rectangular window of the FFT as a strided view of the root, without copying.
+   * @note The window must lie within the stored columns (cols(ROOT): W, or W/2+1 for half spectra). Negative
+   * frequencies sit at the end of each axis, so a band around zero spans up to four windows.
+   * @note In lazy mode, this flushes the pending updates first (see flush() for thread safety). The view is invalidated
+   * by the next update.
+   *
+   * @param u0 First row frequency.
+   * @param v0 First column frequency.
+   * @param rows Number of row frequencies.
+   * @param columns Number of column frequencies.
+   * @return The rows x columns window starting at bin (u0, v0).
+   */
+  [[nodiscard]] Eigen::Map<const matrix, 0, Eigen::OuterStride<>> window(const unsigned int u0, const unsigned int v0, const unsigned int rows, const unsigned int columns) const {
+    flush();
+    return {node(ROOT, 0) + u0 + static_cast<std::size_t>(v0) * H, rows, columns, Eigen::OuterStride<>(H)};
+  }
+
+  /**
+   * @brief Copy a window of the FFT into a caller-provided row-major buffer.
+   *
+   * @param out Output buffer of rows x columns elements: out[i * columns + j] is the bin (u0 + i, v0 + j).
+   * @param u0 First row frequency.
+   * @param v0 First column frequency.
+   * @param rows Number of row frequencies.
+   * @param columns Number of column frequencies (see window()).
+   */
+  void copyTo(complex *out, const unsigned int u0 = 0, const unsigned int v0 = 0, const unsigned int rows = H, const unsigned int columns = cols(ROOT)) const {
+    Eigen::Map<Eigen::Matrix<complex, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(out, rows, columns) = window(u0, v0, rows, columns);
+  }
+
+  /**
+   * @brief Copy a window of the FFT into caller-provided row-major buffers of real and imaginary parts.
+   *
+   * @param real Output buffer of rows x columns real parts, laid out as in copyTo(complex *, ...).
+   * @param imag Output buffer of rows x columns imaginary parts.
+   * @param u0 First row frequency.
+   * @param v0 First column frequency.
+   * @param rows Number of row frequencies.
+   * @param columns Number of column frequencies (see window()).
+   */
+  void copyTo(Scalar *real, Scalar *imag, const unsigned int u0 = 0, const unsigned int v0 = 0, const unsigned int rows = H, const unsigned int columns = cols(ROOT)) const {
+    using Plane = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    const Eigen::Map<const matrix, 0, Eigen::OuterStride<>> x = window(u0, v0, rows, columns);
+    Eigen::Map<Plane>(real, rows, columns) = x.real();
+    Eigen::Map<Plane>(imag, rows, columns) = x.imag();
+  }
+
+  /**
+   * @brief Get the number of stored columns of the FFT: W, or W/2+1 for half spectra.
+   * @return The number of columns of getFFT().
+   */
+  [[nodiscard]] static constexpr unsigned int spectrumCols() {
+    return cols(ROOT);
+  }
+
+  /**
+   * @brief Get the DC bin of the FFT, the sum of the pixels.
+   * @return The FFT bin (0, 0).
+   */
+  [[nodiscard]] complex dc() const {
+    flush();
+    return node(ROOT, 0)[0];
+  }
+
+  /**
+   * @brief Enable or disable the derived outputs: the power spectrum, the total energy and the energy of radial bands.
+   *
+   * They are refreshed along with the root, so only by the updates that change it: the root butterflies compute the
+   * power and band energies of every column they write while it is still in cache, and only the column sums are added
+   * up afterwards, so reading them takes no pass over the spectrum.
+   *
+   * @param enabled True to maintain the derived outputs, false to drop them.
+   * @param edges Ascending radii, in cycles per pixel, bounding the bands: band k holds the bins whose frequency
+   * (fu/H, fv/W), folded to [0, 0.5] on each axis, has a norm in [edges[k], edges[k + 1]). Up to 255 edges.
+   */
+  void setFeatures(const bool enabled, const std::vector<double> &edges = {}) {
+    features_ = enabled;
+    bands_ = enabled && edges.size() > 1 ? std::min<std::size_t>(edges.size(), NO_BAND) - 1 : 0;
+    runs_ = {};
+    firstRun_ = {};
+    if(!enabled) {
+      power_ = {};
+      columnSums_ = {};
+      bandEnergy_ = {};
+      return;
+    }
+    for(unsigned int v = 0; v < cols(ROOT); v++) {
+      firstRun_.push_back(static_cast<uint32_t>(runs_.size()));
+      for(unsigned int u = 0; u < H; u++) {
+        const double fu = static_cast<double>(std::min(u, H - u)) / H;
+        const double fv = static_cast<double>(std::min(v, W - v)) / W;
+        const auto k = std::upper_bound(edges.begin(), edges.begin() + static_cast<std::ptrdiff_t>(bands_ + 1), std::sqrt(fu * fu + fv * fv)) - edges.begin();
+        const uint32_t band = k > 0 && static_cast<std::size_t>(k) <= bands_ ? static_cast<uint32_t>(k - 1) : NO_BAND;
+        if(u > 0 && runs_.back().band == band) {
+          runs_.back().end++;
+        } else {
+          runs_.push_back({u, u + 1, band});
+        }
+      }
+    }
+    firstRun_.push_back(static_cast<uint32_t>(runs_.size()));
+    power_.resize(static_cast<std::size_t>(H) * cols(ROOT));
+    columnSums_.resize(static_cast<std::size_t>(cols(ROOT)) * (bands_ + 1));
+    bandEnergy_.resize(bands_ + 1);
+    flush();
+    measure();
+  }
+
+  /**
+   * @brief Check whether the derived outputs are maintained.
+   * @return True if they are enabled, false otherwise.
+   */
+  [[nodiscard]] bool features() const {
+    return features_;
+  }
+
+  /**
+   * @brief Get the power spectrum |X|^2, laid out as getFFT() (see setFeatures()).
+   * @note In lazy mode, this flushes the pending updates first.
+   *
+   * @return The power spectrum, or an empty matrix if the derived outputs are disabled.
+   */
+  [[nodiscard]] Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>> getPower() const {
+    flush();
+    return {power_.data(), features_ ? H : 0, features_ ? cols(ROOT) : 0};
+  }
+
+  /**
+   * @brief Get the energy (sum of |X|^2 over the full spectrum) of a band (see setFeatures()).
+   *
+   * @param band Band index.
+   * @return The energy of the band.
+   */
+  [[nodiscard]] double bandEnergy(const std::size_t band) const {
+    flush();
+    return bandEnergy_[band];
+  }
+
+  /**
+   * @brief Get the number of bands (see setFeatures()).
+   * @return The number of bands.
+   */
+  [[nodiscard]] std::size_t bands() const {
+    return bands_;
+  }
+
+  /**
+   * @brief Get the total energy, the sum of |X|^2 over the full spectrum (see setFeatures()).
+   * @return The total energy.
+   */
+  [[nodiscard]] double totalEnergy() const {
+    flush();
+    return features_ ? bandEnergy_[bands_] : 0.0;
+  }
+
+#ifdef EFFT_USE_FFTW3
+  /**
+   * @brief Get the FFT ground truth (FFTW) result as an Eigen matrix of complex floats.
+   *
+   * @return The ground truth FFT result.
+   */
+  [[nodiscard]] inline cfloatmat getGroundTruthFFT() const {
+    return Eigen::Map<const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(reinterpret_cast<const std::complex<double> *>(fftwOutput_), H, W).template cast<cfloat>();
+  }
+
+  /**
+   * @brief Check the difference between the computed FFT and the ground truth FFT (FFTW).
+   * @note The difference is taken in double precision, so it measures the accuracy of Traits::Scalar and
+   * Traits::Compact.
+   *
+   * @return The norm of the difference between the computed FFT and the ground truth FFT.
+   */
+  [[nodiscard]] inline double check() const {
+    const Eigen::Map<const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> truth(reinterpret_cast<const std::complex<double> *>(fftwOutput_), H, W);
+    return (getFFT().template cast<std::complex<double>>() - truth.leftCols(cols(ROOT))).norm();
+  }
+#endif
+};
+
+/**
+ * @brief Sliding time-window eFFT: the FFT of the pixels activated within the last window microseconds.
+ *
+ * An 'on' stimulus (re)activates its pixel, an 'off' stimulus deactivates it right away, and a pixel that is not
+ * reactivated within the window is switched off automatically. Activations are queued in time order in a ring buffer
+ * next to the last activation time of every pixel, so the expirations that are due are popped from the head of the ring
+ * and the entries left behind by reactivated pixels are skipped. The due expirations are merged with the new stimuli
+ * into a single packet with one stimulus per pixel, carrying its final state, so every update traverses the tree once.
+ *
+ * @note Timestamps are expected in non-decreasing order; a late stimulus is taken as arriving at the latest timestamp.
+ *
+ * @tparam W Frame width.
+ * @tparam H Frame height.
+ * @tparam Traits Engine traits (see eFFTTraits).
+ */
+template <unsigned int W, unsigned int H = W, typename Traits = eFFTTraits>
+class eFFTWindow {
+private:
+  static constexpr std::size_t AREA = static_cast<std::size_t>(W) * H;
+  static constexpr uint64_t INACTIVE = ~uint64_t{0};
+  static constexpr std::size_t RING_MIN = 1024;
+
+  struct Activation {
+    uint64_t t;
+    uint32_t pixel;
+  };
+
+  eFFT<W, H, Traits> efft_;
+  uint64_t window_;
+  uint64_t now_{0};
+  std::size_t active_{0};
+  std::vector<uint64_t> last_;
+  std::vector<Activation> ring_;
+  std::size_t head_{0};
+  std::size_t queued_{0};
+  std::vector<uint32_t> touched_;
+  PixelTable seen_;
+  Stimuli packet_;
+
+  /**
+   * @brief Queues an activation, doubling the ring if it is full.
+   *
+   * @param pixel Pixel index.
+   * @param t Activation time.
+   */
+  void push(const uint32_t pixel, const uint64_t t) {
+    if(queued_ == ring_.size()) {
+      std::vector<Activation> grown(std::max(RING_MIN, ring_.size() * 2));
+      for(std::size_t i = 0; i < queued_; i++) {
+        grown[i] = ring_[(head_ + i) & (ring_.size() - 1)];
+      }
+      ring_.swap(grown);
+      head_ = 0;
+    }
+    ring_[(head_ + queued_++) & (ring_.size() - 1)] = {t, pixel};
+  }
+
+  /**
+   * @brief Records a pixel whose state has to be sent in the next packet.
+   *
+   * @param pixel Pixel index.
+   */
+  void touch(const uint32_t pixel) {
+    if(seen_.emplace(pixel, 0).second) {
+      touched_.push_back(pixel);
+    }
+  }
+
+  /**
+   * @brief Deactivates the pixels whose last activation fell out of the window.
+   */
+  void expire() {
+    while(queued_ > 0 && now_ - ring_[head_].t >= window_) {
+      const Activation a = ring_[head_];
+      head_ = (head_ + 1) & (ring_.size() - 1);
+      queued_--;
+      if(last_[a.pixel] == a.t) {
+        last_[a.pixel] = INACTIVE;
+        active_--;
+        touch(a.pixel);
+      }
+    }
+  }
+
+  /**
+   * @brief Sends the final state of the touched pixels to the engine as a single packet.
+   *
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool commit() {
+    packet_.clear();
+    for(const uint32_t pixel : touched_) {
+      packet_.emplace_back(pixel / W, pixel % W, last_[pixel] != INACTIVE);
+    }
+    touched_.clear();
+    return efft_.update(packet_);
+  }
+
+public:
+  /**
+   * @brief Constructs a windowed eFFT.
+   *
+   * @param window Window length in microseconds.
+   */
+  explicit eFFTWindow(const uint64_t window) : window_{window}, last_(AREA, INACTIVE) {}
+
+  /**
+   * @brief Clears the window and the FFT.
+   */
+  void initialize() {
+    efft_.initialize();
+    std::fill(last_.begin(), last_.end(), INACTIVE);
+    head_ = 0;
+    queued_ = 0;
+    active_ = 0;
+    now_ = 0;
+  }
+
+  /**
+   * @brief Clears the window and the FFT in place, in time proportional to the queued activations (see eFFT::reset()).
+   */
+  void reset() {
+    efft_.reset();
+    for(std::size_t i = 0; i < queued_; i++) {
+      last_[ring_[(head_ + i) & (ring_.size() - 1)].pixel] = INACTIVE;
+    }
+    head_ = 0;
+    queued_ = 0;
+    active_ = 0;
+    now_ = 0;
+  }
+
+  /**
+   * @brief Sets the window length.
+   * @note The new length applies from the next update on.
+   *
+   * @param window Window length in microseconds.
+   */
+  void setWindow(const uint64_t window) {
+    window_ = window;
+  }
+
+  /**
+   * @brief Get the window length.
+   *
+   * @return Window length in microseconds.
+   */
+  [[nodiscard]] uint64_t window() const {
+    return window_;
+  }
+
+  /**
+   * @brief Get the current time, the latest timestamp seen.
+   *
+   * @return Current time in microseconds.
+   */
+  [[nodiscard]] uint64_t now() const {
+    return now_;
+  }
+
+  /**
+   * @brief Get the number of active pixels.
+   *
+   * @return Number of pixels activated within the window.
+   */
+  [[nodiscard]] std::size_t active() const {
+    return active_;
+  }
+
+  /**
+   * @brief Get the memory used by the engine and the window bookkeeping.
+   *
+   * @return Size in bytes.
+   */
+  [[nodiscard]] std::size_t footprint() const {
+    return efft_.footprint() + last_.capacity() * sizeof(uint64_t) + ring_.capacity() * sizeof(Activation) + touched_.capacity() * sizeof(uint32_t) + packet_.capacity() * sizeof(Stimulus);
+  }
+
+  /**
+   * @brief Get the underlying engine, e.g. to configure it.
+   * @note Stimuli fed to the engine directly bypass the window.
+   *
+   * @return The engine.
+   */
+  [[nodiscard]] eFFT<W, H, Traits> &engine() {
+    return efft_;
+  }
+
+  /**
+   * @brief Get the underlying engine.
+   *
+   * @return The engine.
+   */
+  [[nodiscard]] const eFFT<W, H, Traits> &engine() const {
+    return efft_;
+  }
+
+  /**
+   * @brief Updates the window with multiple stimuli and expires the activations that fell out of it.
+   *
+   * @param pv Pointer to the first stimulus.
+   * @param count Number of stimuli.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const TimedStimulus *pv, const std::size_t count) {
+    seen_.reset(AREA);
+    for(std::size_t i = 0; i < count; i++) {
+      const uint32_t pixel = (pv[i].row & (H - 1)) * W + (pv[i].col & (W - 1)); // wraps around as in eFFT
+      now_ = std::max(now_, pv[i].t);
+      if(pv[i].state) {
+        active_ += static_cast<std::size_t>(last_[pixel] == INACTIVE);
+        last_[pixel] = now_;
+        push(pixel, now_);
+      } else if(last_[pixel] != INACTIVE) {
+        last_[pixel] = INACTIVE;
+        active_--;
+      }
+      touch(pixel);
+    }
+    expire();
+    return commit();
+  }
+
+  /**
+   * @brief Updates the window with multiple stimuli.
+   *
+   * @param pv The stimuli to update.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const TimedStimuli &pv) { return update(pv.data(), pv.size()); }
+
+  /**
+   * @brief Updates the window with a single stimulus.
+   *
+   * @param p The stimulus to update.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool update(const TimedStimulus &p) { return update(&p, 1); }
+
+  /**
+   * @brief Moves the time forward without new stimuli, expiring the activations that fell out of the window.
+   *
+   * @param t New time in microseconds.
+   * @return True if the update changed the FFT state, false otherwise.
+   */
+  bool advance(const uint64_t t) {
+    seen_.reset(AREA);
+    now_ = std::max(now_, t);
+    expire();
+    return commit();
+  }
+
+  /**
+   * @brief Get the FFT of the active pixels (see eFFT::getFFT()).
+   *
+   * @return The FFT result.
+   */
+  [[nodiscard]] auto getFFT() const {
+    return efft_.getFFT();
+  }
+};
+
+/**
+ * @brief Asynchronous eFFT: stimuli are queued by a producer and applied by a worker thread.
+ *
+ * The producer pushes stimuli into a lock-free single-producer/single-consumer ring and never blocks: when the ring is
+ * full, the stimuli that do not fit are dropped and counted. The worker drains the ring in packets of whatever has
+ * accumulated while the previous packet was applied (up to a maximum), so packets grow with the load. After every
+ * update that changes the FFT, the worker copies the root into one of two snapshot buffers, alternately, guarded by a
+ * sequence counter, and publishes its version; readers copy the latest snapshot without locks and retry only if the
+ * worker overwrote that buffer meanwhile. The buffers are arrays of atomic words accessed with relaxed loads and stores,
+ * so a reader that overlaps a rewrite gets a torn copy that it discards, never a data race.
+ *
+ * @note The worker waits on a condition variable when the ring stays empty. The producer only notifies it, without
+ * locking, and a wakeup lost to that race costs at most IDLE_WAIT.
+ *
+ * @tparam W Frame width.
+ * @tparam H Frame height.
+ * @tparam Traits Engine traits (see eFFTTraits).
+ */
+template <unsigned int W, unsigned int H = W, typename Traits = eFFTTraits>
+class eFFTPipeline {
+public:
+  using complex = std::complex<typename Traits::Scalar>;
+  using matrix = Eigen::Matrix<complex, Eigen::Dynamic, Eigen::Dynamic>;
+
+private:
+  static constexpr std::size_t SIZE = static_cast<std::size_t>(H) * eFFT<W, H, Traits>::spectrumCols();
+  static constexpr std::size_t BYTES = SIZE * sizeof(complex);
+  static constexpr std::size_t WORDS = (BYTES + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  static constexpr unsigned int IDLE_SPINS = 64;
+  static constexpr std::chrono::milliseconds IDLE_WAIT{1};
+
+  struct Slot {
+    std::atomic<uint64_t> sequence{0}; // odd while the worker writes the buffer
+    std::unique_ptr<std::atomic<uint64_t>[]> data;
+  };
+
+  eFFT<W, H, Traits> efft_;
+  SpscRing<Stimulus> ring_;
+  std::size_t maxPacket_;
+  Stimuli packet_;
+  Slot slots_[2];
+  std::atomic<uint64_t> version_{0};
+  std::size_t pushed_{0};
+  std::atomic<std::size_t> applied_{0};
+  std::atomic<std::size_t> dropped_{0};
+  std::atomic<bool> stop_{true};
+  std::atomic<bool> sleeping_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread worker_;
+
+  /**
+   * @brief Copies the root into the snapshot buffer that readers are not directed to, then publishes it.
+   */
+  void publish() {
+    const uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    Slot &slot = slots_[version & 1];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const auto x = efft_.getFFT();
+    const auto *bytes = reinterpret_cast<const unsigned char *>(x.data());
+    for(std::size_t i = 0; i < WORDS; i++) {
+      uint64_t word = 0;
+      std::memcpy(&word, bytes + i * sizeof(uint64_t), std::min(sizeof(uint64_t), BYTES - i * sizeof(uint64_t)));
+      slot.data[i].store(word, std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    version_.store(version, std::memory_order_release);
+  }
+
+  void work() {
+    unsigned int idle = 0;
+    while(true) {
+      const std::size_t n = ring_.pop(packet_, maxPacket_);
+      if(n > 0) {
+        idle = 0;
+        if(efft_.update(packet_)) {
+          publish();
+        }
+        applied_.fetch_add(n, std::memory_order_release);
+        continue;
+      }
+      if(stop_.load(std::memory_order_acquire)) {
+        if(ring_.empty()) {
+          return;
+        }
+        continue;
+      }
+      if(++idle < IDLE_SPINS) {
+        std::this_thread::yield();
+        continue;
+      }
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(ring_.empty()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, IDLE_WAIT);
+      }
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+public:
+  /**
+   * @brief Constructs a pipeline and starts its worker.
+   *
+   * @param capacity Minimum number of stimuli the ring holds, rounded up to a power of two.
+   * @param maxPacket Maximum number of stimuli per packet.
+   */
+  explicit eFFTPipeline(const std::size_t capacity = std::size_t{1} << 16U, const std::size_t maxPacket = 4096) : ring_{capacity}, maxPacket_{maxPacket} {
+    slots_[0].data = std::make_unique<std::atomic<uint64_t>[]>(WORDS);
+    slots_[1].data = std::make_unique<std::atomic<uint64_t>[]>(WORDS);
+    start();
+  }
+
+  ~eFFTPipeline() { stop(); }
+
+  eFFTPipeline(const eFFTPipeline &) = delete;
+  eFFTPipeline &operator=(const eFFTPipeline &) = delete;
+
+  /**
+   * @brief Starts the worker and publishes the current FFT.
+   */
+  void start() {
+    if(!stop_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    publish();
+    stop_.store(false, std::memory_order_release);
+    worker_ = std::thread([this] { work(); });
+  }
+
+  /**
+   * @brief Applies the queued stimuli and stops the worker, e.g. to configure or reset the engine.
+   */
+  void stop() {
+    if(stop_.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+    cv_.notify_one();
+    worker_.join();
+  }
+
+  /**
+   * @brief Queues stimuli, as many as fit in the ring (producer side; never blocks).
+   *
+   * @param pv Pointer to the first stimulus.
+   * @param count Number of stimuli.
+   * @return The number of stimuli queued; the rest are dropped.
+   */
+  std::size_t push(const Stimulus *pv, const std::size_t count) {
+    const std::size_t n = ring_.push(pv, count);
+    pushed_ += n;
+    if(n < count) {
+      dropped_.fetch_add(count - n, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleeping_.load(std::memory_order_relaxed)) {
+      cv_.notify_one();
+    }
+    return n;
+  }
+
+  /**
+   * @brief Queues stimuli (producer side; never blocks).
+   *
+   * @param pv The stimuli to queue.
+   * @return The number of stimuli queued; the rest are dropped.
+   */
+  std::size_t push(const Stimuli &pv) { return push(pv.data(), pv.size()); }
+
+  /**
+   * @brief Queues a single stimulus (producer side; never blocks).
+   *
+   * @param p The stimulus to queue.
+   * @return True if it was queued, false if the ring was full.
+   */
+  bool push(const Stimulus &p) { return push(&p, 1) == 1; }
+
+  /**
+   * @brief Waits until the worker has applied every stimulus queued so far and published the result (producer side).
+   */
+  void drain() const {
+    while(applied_.load(std::memory_order_acquire) < pushed_ && !stop_.load(std::memory_order_relaxed)) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Get the version of the latest snapshot, which increases with every update that changed the FFT.
+   * @return The version.
+   */
+  [[nodiscard]] uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Copy the latest snapshot of the FFT (laid out as eFFT::getFFT(), column-major) without locking.
+   *
+   * @param out Output buffer of H x eFFT::spectrumCols() elements.
+   * @return The version of the snapshot.
+   */
+  uint64_t snapshot(complex *out) const {
+    while(true) {
+      const uint64_t version = version_.load(std::memory_order_acquire);
+      const Slot &slot = slots_[version & 1];
+      const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if((sequence & 1) == 0) {
+        auto *bytes = reinterpret_cast<unsigned char *>(out);
+        for(std::size_t i = 0; i < WORDS; i++) {
+          const uint64_t word = slot.data[i].load(std::memory_order_relaxed);
+          std::memcpy(bytes + i * sizeof(uint64_t), &word, std::min(sizeof(uint64_t), BYTES - i * sizeof(uint64_t)));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.sequence.load(std::memory_order_relaxed) == sequence) {
+          return version;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Copy the latest snapshot of the FFT into a matrix without locking.
+   *
+   * @param out Output matrix, resized to H x eFFT::spectrumCols() (allocates only the first time).
+   * @return The version of the snapshot.
+   */
+  uint64_t snapshot(matrix &out) const {
+    out.resize(H, eFFT<W, H, Traits>::spectrumCols());
+    return snapshot(out.data());
+  }
+
+  /**
+   * @brief Get the number of stimuli dropped because the ring was full.
+   * @return The number of stimuli dropped.
+   */
+  [[nodiscard]] std::size_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the memory used by the engine, the ring and the snapshots.
+   *
+   * @return Size in bytes.
+   */
+  [[nodiscard]] std::size_t footprint() const {
+    return efft_.footprint() + ring_.capacity() * sizeof(Stimulus) + packet_.capacity() * sizeof(Stimulus) + 2 * WORDS * sizeof(uint64_t);
+  }
+
+  /**
+   * @brief Get the underlying engine, e.g. to configure it.
+   * @note Only while the worker is stopped (see stop()).
+   *
+   * @return The engine.
+   */
+  [[nodiscard]] eFFT<W, H, Traits> &engine() {
+    return efft_;
   }
-#endif
 };
 
 #endif // EFFT_HPP
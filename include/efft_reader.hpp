@@ -0,0 +1,568 @@
+/**
+ * @file efft_reader.hpp
+ * @brief Event file readers for eFFT
+ * @author Raul Tapia (raultapia.com)
+ * @copyright GNU General Public License v3.0
+ * @see https://github.com/raultapia/efft
+ * @note This is a header-only library
+ */
+#ifndef EFFT_READER_HPP
+#define EFFT_READER_HPP
+
+#include "efft.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EFFT_HAS_MMAP
+#endif
+
+/**
+ * @brief Encodings of event files.
+ */
+enum class EventFormat {
+  Packed, ///< eFFT packed events: a 16-byte header and one little-endian 64-bit word per event (see writePackedEvents()).
+  EVT2,   ///< Prophesee EVT 2.0: '%' header lines and 32-bit little-endian words.
+  EVT3,   ///< Prophesee EVT 3.0: '%' header lines and 16-bit little-endian words, with vectorized events.
+  AEDAT2  ///< jAER AEDAT 2.0 (DAVIS addresses): '#' header lines and big-endian 32-bit address and timestamp pairs.
+};
+
+/**
+ * @brief Layout of the eFFT packed event words.
+ */
+struct PackedEvent {
+  static constexpr char MAGIC[8] = {'e', 'F', 'F', 'T', 'e', 'v', 't', '1'};
+  static constexpr unsigned int TIME_BITS = 39; ///< Timestamp in microseconds, wrapping around every 2^39 us (about 6 days).
+  static constexpr unsigned int COORD_BITS = 12; ///< Column and row, below 4096.
+  static constexpr std::size_t HEADER_SIZE = 16; ///< Magic, then 32-bit width and height.
+  static constexpr unsigned int COORD_LIMIT = 1U << COORD_BITS;
+
+  /**
+   * @brief Encode an event; every field is masked to its width, so the timestamp wraps and coordinates of
+   * COORD_LIMIT or more would alias (writePackedEvents() rejects them).
+   */
+  static constexpr uint64_t encode(const uint64_t t, const unsigned int x, const unsigned int y, const bool p) {
+    constexpr uint64_t coord = COORD_LIMIT - 1;
+    return (t & ((uint64_t{1} << TIME_BITS) - 1)) | ((x & coord) << TIME_BITS) | ((y & coord) << (TIME_BITS + COORD_BITS)) | (static_cast<uint64_t>(p) << 63U);
+  }
+
+  /**
+   * @brief Store a value as little-endian bytes, whatever the byte order of the host.
+   */
+  template <typename T>
+  static void store(char *p, const T value) {
+    for(unsigned int i = 0; i < sizeof(T); i++) {
+      p[i] = static_cast<char>(value >> (8U * i));
+    }
+  }
+};
+
+/**
+ * @brief Write events in the eFFT packed format (EventFormat::Packed).
+ *
+ * Timestamps are stored modulo 2^39 us (PackedEvent::TIME_BITS), so recordings longer than about 6 days wrap around.
+ *
+ * @param path File path.
+ * @param events Pointer to the first event (row, col, timestamp and state).
+ * @param count Number of events.
+ * @param width Sensor width.
+ * @param height Sensor height.
+ * @return True on success, false if a coordinate does not fit in PackedEvent::COORD_BITS (nothing is written then) or
+ * the file cannot be written.
+ */
+inline bool writePackedEvents(const std::string &path, const TimedStimulus *events, const std::size_t count, const uint32_t width, const uint32_t height) {
+  for(std::size_t i = 0; i < count; i++) {
+    if(events[i].row >= PackedEvent::COORD_LIMIT || events[i].col >= PackedEvent::COORD_LIMIT) {
+      return false;
+    }
+  }
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  char header[PackedEvent::HEADER_SIZE];
+  std::memcpy(header, PackedEvent::MAGIC, sizeof(PackedEvent::MAGIC));
+  PackedEvent::store(header + sizeof(PackedEvent::MAGIC), width);
+  PackedEvent::store(header + sizeof(PackedEvent::MAGIC) + sizeof(width), height);
+  os.write(header, sizeof(header));
+  const std::size_t batch = std::min<std::size_t>(count, 1U << 16U);
+  std::vector<char> bytes(batch * sizeof(uint64_t));
+  for(std::size_t first = 0; first < count; first += batch) {
+    const std::size_t n = std::min(batch, count - first);
+    for(std::size_t i = 0; i < n; i++) {
+      const TimedStimulus &e = events[first + i];
+      PackedEvent::store(bytes.data() + i * sizeof(uint64_t), PackedEvent::encode(e.t, e.col, e.row, e.state));
+    }
+    os.write(bytes.data(), static_cast<std::streamsize>(n * sizeof(uint64_t)));
+  }
+  return static_cast<bool>(os.flush());
+}
+
+/**
+ * @brief Streaming reader of event files.
+ *
+ * The file is memory-mapped (read into memory where mmap is not available) and decoded on demand, in batches, straight
+ * into a caller-provided packet (Stimuli or TimedStimuli) that is cleared and refilled by every read, so replaying a
+ * recording does not allocate once the packet has grown. Packets hold either a number of events or a time slice.
+ * Events map to stimuli as row = y, col = x and state = polarity.
+ */
+class EventReader {
+public:
+  EventReader() = default;
+
+  /**
+   * @brief Open an event file.
+   *
+   * @param path File path.
+   * @param format File encoding.
+   */
+  EventReader(const std::string &path, const EventFormat format) { open(path, format); }
+
+  ~EventReader() { close(); }
+
+  EventReader(const EventReader &) = delete;
+  EventReader &operator=(const EventReader &) = delete;
+
+  /**
+   * @brief Open an event file.
+   *
+   * @param path File path.
+   * @param format File encoding.
+   * @return True on success, false if the file cannot be read or its header does not match the format.
+   */
+  bool open(const std::string &path, const EventFormat format) {
+    close();
+#ifdef EFFT_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+      return false;
+    }
+    struct stat st {};
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *map = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if(map != MAP_FAILED) {
+        mapping_ = map;
+        mapped_ = static_cast<std::size_t>(st.st_size);
+#ifdef MADV_SEQUENTIAL
+        madvise(map, mapped_, MADV_SEQUENTIAL);
+#endif
+      }
+    }
+    ::close(fd);
+    if(mapping_ == nullptr) {
+      return false;
+    }
+    return attach(mapping_, mapped_, format);
+#else
+    std::ifstream is(path, std::ios::binary | std::ios::ate);
+    if(!is) {
+      return false;
+    }
+    buffer_.resize(static_cast<std::size_t>(is.tellg()));
+    is.seekg(0);
+    if(!is.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) {
+      return false;
+    }
+    return attach(buffer_.data(), buffer_.size(), format);
+#endif
+  }
+
+  /**
+   * @brief Read events from memory, e.g. a buffer or a mapping owned by the caller, which must outlive the reader.
+   *
+   * @param data Pointer to the file contents.
+   * @param size Size of the contents in bytes.
+   * @param format File encoding.
+   * @return True on success, false if the header does not match the format.
+   */
+  bool open(const void *data, const std::size_t size, const EventFormat format) {
+    close();
+    return attach(data, size, format);
+  }
+
+  /**
+   * @brief Close the file.
+   */
+  void close() {
+#ifdef EFFT_HAS_MMAP
+    if(mapping_ != nullptr) {
+      munmap(mapping_, mapped_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapped_ = 0;
+    buffer_.clear();
+    data_ = begin_ = end_ = position_ = nullptr;
+  }
+
+  /**
+   * @brief Check whether a file is open.
+   * @return True if a file is open, false otherwise.
+   */
+  [[nodiscard]] bool isOpen() const {
+    return begin_ != nullptr;
+  }
+
+  /**
+   * @brief Get the sensor width given by the header.
+   * @return The width, or 0 if the header does not give it.
+   */
+  [[nodiscard]] unsigned int width() const {
+    return width_;
+  }
+
+  /**
+   * @brief Get the sensor height given by the header.
+   * @return The height, or 0 if the header does not give it.
+   */
+  [[nodiscard]] unsigned int height() const {
+    return height_;
+  }
+
+  /**
+   * @brief Drop the events outside a frame, e.g. the eFFT frame when it is smaller than the sensor.
+   *
+   * @param width Frame width (columns).
+   * @param height Frame height (rows).
+   */
+  void setFrame(const unsigned int width, const unsigned int height) {
+    frameWidth_ = width;
+    frameHeight_ = height;
+  }
+
+  /**
+   * @brief Go back to the first event.
+   */
+  void rewind() {
+    position_ = begin_;
+    timeHigh_ = 0;
+    timeLow_ = 0;
+    epoch_ = 0;
+    y_ = 0;
+    base_ = 0;
+    polarity_ = false;
+    mask_ = 0;
+    pending_ = false;
+  }
+
+  /**
+   * @brief Get the number of bytes decoded so far, header included.
+   * @return The offset of the decoder in the file.
+   */
+  [[nodiscard]] std::size_t offset() const {
+    return static_cast<std::size_t>(position_ - data_);
+  }
+
+  /**
+   * @brief Read the next events, up to a number of them.
+   *
+   * @param packet Output packet (Stimuli or TimedStimuli), cleared first.
+   * @param count Maximum number of events.
+   * @return True if the packet holds any event, false at the end of the file.
+   */
+  template <typename Packet>
+  bool read(Packet &packet, const std::size_t count) {
+    packet.clear();
+    Event e;
+    while(packet.size() < count && next(e)) {
+      push(packet, e);
+    }
+    return !packet.empty();
+  }
+
+  /**
+   * @brief Read the events of the next time slice, which starts at the first event not read yet.
+   *
+   * @param packet Output packet (Stimuli or TimedStimuli), cleared first.
+   * @param duration Length of the slice in microseconds.
+   * @return True if the packet holds any event, false at the end of the file.
+   */
+  template <typename Packet>
+  bool readFor(Packet &packet, const uint64_t duration) {
+    packet.clear();
+    Event e;
+    if(!next(e)) {
+      return false;
+    }
+    const uint64_t end = e.t + duration;
+    do {
+      if(e.t >= end) {
+        lookahead_ = e;
+        pending_ = true;
+        break;
+      }
+      push(packet, e);
+    } while(next(e));
+    return true;
+  }
+
+private:
+  struct Event {
+    uint64_t t;
+    unsigned int x;
+    unsigned int y;
+    bool p;
+  };
+
+  void *mapping_{nullptr};
+  std::size_t mapped_{0};
+  std::vector<char> buffer_;
+  const uint8_t *data_{nullptr};
+  const uint8_t *begin_{nullptr};
+  const uint8_t *end_{nullptr};
+  const uint8_t *position_{nullptr};
+  EventFormat format_{EventFormat::Packed};
+  unsigned int width_{0};
+  unsigned int height_{0};
+  unsigned int frameWidth_{~0U};
+  unsigned int frameHeight_{~0U};
+  // decoder state
+  uint64_t timeHigh_{0};
+  uint64_t timeLow_{0};
+  uint64_t epoch_{0};
+  unsigned int y_{0};
+  unsigned int base_{0};
+  bool polarity_{false};
+  unsigned int vector_{0};
+  uint32_t mask_{0};
+  Event lookahead_{};
+  bool pending_{false};
+
+  /**
+   * @brief Point the decoder at the file contents and parse the header.
+   */
+  bool attach(const void *data, const std::size_t size, const EventFormat format) {
+    data_ = begin_ = static_cast<const uint8_t *>(data);
+    end_ = begin_ + size;
+    format_ = format;
+    width_ = 0;
+    height_ = 0;
+    if(format == EventFormat::Packed) {
+      if(size < PackedEvent::HEADER_SIZE || std::memcmp(begin_, PackedEvent::MAGIC, sizeof(PackedEvent::MAGIC)) != 0) {
+        close();
+        return false;
+      }
+      width_ = le32(begin_ + sizeof(PackedEvent::MAGIC));
+      height_ = le32(begin_ + sizeof(PackedEvent::MAGIC) + 4);
+      begin_ += PackedEvent::HEADER_SIZE;
+    } else if(!skipHeader(format == EventFormat::AEDAT2 ? '#' : '%')) {
+      close();
+      return false;
+    }
+    rewind();
+    return true;
+  }
+
+  /**
+   * @brief Skip the header lines (starting with a marker) and parse the sensor geometry if they give it.
+   * @return False if a header line gives a malformed geometry.
+   */
+  bool skipHeader(const char marker) {
+    while(begin_ < end_ && *begin_ == static_cast<uint8_t>(marker)) {
+      const uint8_t *eol = static_cast<const uint8_t *>(std::memchr(begin_, '\n', static_cast<std::size_t>(end_ - begin_)));
+      const uint8_t *next = eol != nullptr ? eol + 1 : end_;
+      const std::string line(reinterpret_cast<const char *>(begin_), static_cast<std::size_t>(next - begin_));
+      unsigned int w = 0;
+      unsigned int h = 0;
+      const char *stop = nullptr;
+      if(line.compare(0, 11, "% geometry ") == 0) {
+        if(!number(line.c_str() + 11, w, stop) || *stop != 'x' || !number(stop + 1, h, stop)) {
+          return false;
+        }
+        width_ = w;
+        height_ = h;
+      }
+      const std::size_t wp = line.find("width=");
+      const std::size_t hp = line.find("height=");
+      if(wp != std::string::npos && hp != std::string::npos) {
+        if(!number(line.c_str() + wp + 6, w, stop) || !number(line.c_str() + hp + 7, h, stop)) {
+          return false;
+        }
+        width_ = w;
+        height_ = h;
+      }
+      begin_ = next;
+      if(line.compare(0, 5, "% end") == 0) { // binary data may start with the marker byte
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Parse an unsigned decimal number without throwing.
+   * @return False unless the text starts with a digit and the value fits in an unsigned int.
+   */
+  static bool number(const char *text, unsigned int &value, const char *&stop) {
+    if(std::isdigit(static_cast<unsigned char>(*text)) == 0) {
+      return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    const unsigned long parsed = std::strtoul(text, &end, 10);
+    if(errno == ERANGE || parsed > std::numeric_limits<unsigned int>::max()) {
+      return false;
+    }
+    value = static_cast<unsigned int>(parsed);
+    stop = end;
+    return true;
+  }
+
+  template <typename Packet>
+  void push(Packet &packet, const Event &e) const {
+    if constexpr(std::is_same_v<typename Packet::value_type, TimedStimulus>) {
+      packet.emplace_back(e.y, e.x, e.t, e.p);
+    } else {
+      packet.emplace_back(e.y, e.x, e.p);
+    }
+  }
+
+  /**
+   * @brief Decode the next event inside the frame.
+   */
+  bool next(Event &e) {
+    if(pending_) {
+      pending_ = false;
+      e = lookahead_;
+      return true;
+    }
+    do {
+      if(!decode(e)) {
+        return false;
+      }
+    } while(e.x >= frameWidth_ || e.y >= frameHeight_);
+    return true;
+  }
+
+  static uint32_t le16(const uint8_t *p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8U); }
+  static uint32_t le32(const uint8_t *p) { return le16(p) | (le16(p + 2) << 16U); }
+  static uint32_t be32(const uint8_t *p) { return (static_cast<uint32_t>(p[0]) << 24U) | (static_cast<uint32_t>(p[1]) << 16U) | (static_cast<uint32_t>(p[2]) << 8U) | p[3]; }
+
+  /**
+   * @brief Decode the next event of the file.
+   */
+  bool decode(Event &e) {
+    switch(format_) {
+    case EventFormat::Packed:
+      if(end_ - position_ >= 8) {
+        const uint64_t w = static_cast<uint64_t>(le32(position_)) | (static_cast<uint64_t>(le32(position_ + 4)) << 32U);
+        position_ += 8;
+        constexpr uint64_t COORD_MASK = (uint64_t{1} << PackedEvent::COORD_BITS) - 1;
+        e = {w & ((uint64_t{1} << PackedEvent::TIME_BITS) - 1), static_cast<unsigned int>((w >> PackedEvent::TIME_BITS) & COORD_MASK), static_cast<unsigned int>((w >> (PackedEvent::TIME_BITS + PackedEvent::COORD_BITS)) & COORD_MASK), static_cast<bool>(w >> 63U)};
+        return true;
+      }
+      return false;
+    case EventFormat::EVT2:
+      return decodeEVT2(e);
+    case EventFormat::EVT3:
+      return decodeEVT3(e);
+    case EventFormat::AEDAT2:
+      return decodeAEDAT2(e);
+    }
+    return false;
+  }
+
+  bool decodeEVT2(Event &e) {
+    while(end_ - position_ >= 4) {
+      const uint32_t w = le32(position_);
+      position_ += 4;
+      switch(w >> 28U) {
+      case 0x0: // CD_OFF
+      case 0x1: // CD_ON
+        e = {epoch_ + (timeHigh_ | ((w >> 22U) & 0x3FU)), (w >> 11U) & 0x7FFU, w & 0x7FFU, (w >> 28U) == 0x1};
+        return true;
+      case 0x8: { // EVT_TIME_HIGH, 34-bit time wraps around
+        const uint64_t high = static_cast<uint64_t>(w & 0x0FFFFFFFU) << 6U;
+        if(high < timeHigh_) {
+          epoch_ += uint64_t{1} << 34U;
+        }
+        timeHigh_ = high;
+        break;
+      }
+      default: // triggers and vendor words
+        break;
+      }
+    }
+    return false;
+  }
+
+  bool decodeEVT3(Event &e) {
+    for(;;) {
+      if(mask_ != 0) { // drain a vector word one event at a time
+        const unsigned int bit = ctz64(mask_);
+        mask_ &= mask_ - 1;
+        e = {epoch_ + ((timeHigh_ << 12U) | timeLow_), vector_ + bit, y_, polarity_};
+        return true;
+      }
+      if(end_ - position_ < 2) {
+        return false;
+      }
+      const uint32_t w = le16(position_);
+      position_ += 2;
+      switch(w >> 12U) {
+      case 0x0: // EVT_ADDR_Y
+        y_ = w & 0x7FFU;
+        break;
+      case 0x2: // EVT_ADDR_X
+        e = {epoch_ + ((timeHigh_ << 12U) | timeLow_), w & 0x7FFU, y_, static_cast<bool>((w >> 11U) & 1U)};
+        return true;
+      case 0x3: // VECT_BASE_X
+        base_ = w & 0x7FFU;
+        polarity_ = static_cast<bool>((w >> 11U) & 1U);
+        break;
+      case 0x4: // VECT_12
+        vector_ = base_;
+        mask_ = w & 0xFFFU;
+        base_ += 12;
+        break;
+      case 0x5: // VECT_8
+        vector_ = base_;
+        mask_ = w & 0xFFU;
+        base_ += 8;
+        break;
+      case 0x6: // EVT_TIME_LOW
+        timeLow_ = w & 0xFFFU;
+        break;
+      case 0x8: // EVT_TIME_HIGH, 24-bit time wraps around
+        if((w & 0xFFFU) < timeHigh_) {
+          epoch_ += uint64_t{1} << 24U;
+        }
+        timeHigh_ = w & 0xFFFU;
+        break;
+      default: // triggers, continued and vendor words
+        break;
+      }
+    }
+  }
+
+  bool decodeAEDAT2(Event &e) {
+    while(end_ - position_ >= 8) {
+      const uint32_t address = be32(position_);
+      const uint32_t timestamp = be32(position_ + 4);
+      position_ += 8;
+      if((address >> 31U) != 0) { // APS and IMU samples, whose timestamps may lag behind the events
+        continue;
+      }
+      if(timestamp < timeLow_ && timeLow_ - timestamp > (uint64_t{1} << 31U)) { // 32-bit time wraps around, not a slightly late event
+        epoch_ += uint64_t{1} << 32U;
+      }
+      timeLow_ = timestamp;
+      e = {epoch_ + timestamp, (address >> 12U) & 0x3FFU, (address >> 22U) & 0x1FFU, static_cast<bool>((address >> 11U) & 1U)};
+      return true;
+    }
+    return false;
+  }
+};
+
+#endif // EFFT_READER_HPP
@@ -1,10 +1,15 @@
 #include "efft.hpp"
 #include <complex>
+#include <mutex>
 #include <nanobind/eigen/dense.h>
 #include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
 #include <nanobind/stl/bind_vector.h>
+#include <nanobind/stl/complex.h>
 #include <nanobind/stl/string.h>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace nb = nanobind;
@@ -35,25 +40,123 @@ static void bind_stimuli(nb::module_ &m) {
       .def("toggle", &Stimuli::toggle);
 }
 
+using SpectrumView = nb::ndarray<nb::numpy, const std::complex<float>, nb::ndim<2>>;
+using SpectrumBuffer = nb::ndarray<std::complex<float>, nb::ndim<2>, nb::c_contig, nb::device::cpu>;
+template <typename T>
+using Column = nb::ndarray<const T, nb::ndim<1>, nb::device::cpu>;
+template <typename T>
+using Events = nb::ndarray<const T, nb::shape<-1, 3>, nb::device::cpu>;
+using States = nb::ndarray<const bool, nb::ndim<1>, nb::device::cpu>;
+
+// calls on one instance are serialized by its mutex, which update_arrays() takes after releasing the GIL
 template <unsigned int N>
 struct Bindings {
   eFFT<N> eng;
-  void initialize() { eng.initialize(); }
-  bool update(const Stimulus &stimulus) { return eng.update(stimulus); }
-  bool update(Stimuli &stimuli) { return eng.update(stimuli); }
-  Eigen::Matrix<std::complex<float>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> get_fft() const { return eng.getFFT(); }
+  mutable std::mutex mutex;
+  void initialize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    eng.initialize();
+  }
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    eng.reset();
+  }
+  bool update(const Stimulus &stimulus) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return eng.update(stimulus);
+  }
+  bool update(const Stimuli &stimuli) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return eng.update(stimuli);
+  }
+
+  // packets from NumPy arrays: read in place (any stride), converted and applied with the GIL released
+  template <typename T>
+  bool update_arrays(Column<T> rows, Column<T> cols, States states) {
+    const std::size_t count = rows.shape(0);
+    if(cols.shape(0) != count || states.shape(0) != count) throw std::invalid_argument("rows, cols and states must have the same length");
+    nb::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto r = rows.view();
+    const auto c = cols.view();
+    const auto s = states.view();
+    packet.resize(count);
+    for(std::size_t i = 0; i < count; i++) {
+      packet[i] = Stimulus(coordinate(r(i)), coordinate(c(i)), s(i));
+    }
+    return eng.update(packet);
+  }
+  template <typename T>
+  bool update_events(Events<T> events) {
+    nb::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto e = events.view();
+    packet.resize(events.shape(0));
+    for(std::size_t i = 0; i < packet.size(); i++) {
+      packet[i] = Stimulus(coordinate(e(i, 0)), coordinate(e(i, 1)), e(i, 2) != 0);
+    }
+    return eng.update(packet);
+  }
+  template <typename T>
+  static unsigned int coordinate(const T x) {
+    if(static_cast<std::make_unsigned_t<T>>(x) >= N) throw std::out_of_range("event out of the frame");
+    return static_cast<unsigned int>(x);
+  }
+  Eigen::Matrix<std::complex<float>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> get_fft() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return eng.getFFT();
+  }
+  std::complex<float> bin(unsigned int u, unsigned int v) const {
+    if(u >= N || v >= N) throw std::out_of_range("bin out of range");
+    std::lock_guard<std::mutex> lock(mutex);
+    return eng.bin(u, v);
+  }
+  void check_window(unsigned int u0, unsigned int v0, std::size_t rows, std::size_t cols) const {
+    if(u0 + rows > N || v0 + cols > N) throw std::out_of_range("window out of range");
+  }
+  void copy_to(SpectrumBuffer out, unsigned int u0, unsigned int v0) const {
+    check_window(u0, v0, out.shape(0), out.shape(1));
+    std::lock_guard<std::mutex> lock(mutex);
+    eng.copyTo(out.data(), u0, v0, static_cast<unsigned int>(out.shape(0)), static_cast<unsigned int>(out.shape(1)));
+  }
   int framesize() const { return static_cast<int>(eng.framesize()); }
+
+private:
+  Stimuli packet; // reused across update_arrays() calls
 };
 
+// read-only views of the root of the tree (column-major), valid until the next update
+template <unsigned int N>
+static SpectrumView window(Bindings<N> &self, unsigned int u0, unsigned int v0, unsigned int rows, unsigned int cols) {
+  self.check_window(u0, v0, rows, cols);
+  std::lock_guard<std::mutex> lock(self.mutex);
+  return SpectrumView(self.eng.window(u0, v0, rows, cols).data(), {rows, cols}, nb::find(&self), {1, N});
+}
+
+template <unsigned int N, typename T>
+static void bind_arrays(nb::class_<Bindings<N>> &c) {
+  c.def("update_arrays", &Bindings<N>::template update_arrays<T>, "rows"_a, "cols"_a, "states"_a)
+      .def("update_arrays", &Bindings<N>::template update_events<T>, "events"_a);
+}
+
 template <unsigned int N>
 static void bind_efft(nb::module_ &m, const std::string &pyname) {
-  nb::class_<Bindings<N>>(m, pyname.c_str())
+  nb::class_<Bindings<N>> c(m, pyname.c_str());
+  c
       .def(nb::init<>())
       .def("initialize", &Bindings<N>::initialize)
+      .def("reset", &Bindings<N>::reset)
       .def("update", nb::overload_cast<const Stimulus &>(&Bindings<N>::update), "stimulus"_a)
-      .def("update", nb::overload_cast<Stimuli &>(&Bindings<N>::update), "stimuli"_a)
+      .def("update", nb::overload_cast<const Stimuli &>(&Bindings<N>::update), "stimuli"_a)
       .def("get_fft", &Bindings<N>::get_fft)
+      .def("get_fft_view", [](Bindings<N> &self) { return window(self, 0, 0, N, N); })
+      .def("window", &window<N>, "u0"_a, "v0"_a, "rows"_a, "cols"_a)
+      .def("bin", &Bindings<N>::bin, "u"_a, "v"_a)
+      .def("copy_to", &Bindings<N>::copy_to, "out"_a, "u0"_a = 0, "v0"_a = 0)
       .def_prop_ro("framesize", &Bindings<N>::framesize);
+  bind_arrays<N, uint16_t>(c);
+  bind_arrays<N, int32_t>(c);
+  bind_arrays<N, int64_t>(c);
 }
 
 NB_MODULE(_efft, m) {
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+from concurrent.futures import ThreadPoolExecutor
+from efft import Stimulus, Stimuli, eFFT
+import numpy as np
+import os
+import pytest
+import time
+
+# Timing assertions depend on the machine and its load, so they only run with EFFT_BENCHMARK=1
+benchmark = pytest.mark.skipif(os.environ.get("EFFT_BENCHMARK") != "1", reason="set EFFT_BENCHMARK=1 to check speedups")
+
+FRAME_SIZE = 256
+PACKET_SIZE = 5000
+PACKETS = 20
+
+
+def generate_packets(seed):
+    rng = np.random.default_rng(seed)
+    return [
+        (
+            rng.integers(0, FRAME_SIZE, PACKET_SIZE, dtype=np.uint16),
+            rng.integers(0, FRAME_SIZE, PACKET_SIZE, dtype=np.uint16),
+            rng.integers(0, 2, PACKET_SIZE).astype(bool),
+        )
+        for _ in range(PACKETS)
+    ]
+
+
+def feed_stimuli(efft, packets):
+    for rows, cols, states in packets:
+        stimuli = Stimuli()
+        for r, c, s in zip(rows.tolist(), cols.tolist(), states.tolist()):
+            stimuli.append(Stimulus(r, c, s))
+        efft.update(stimuli)
+
+
+def feed_arrays(efft, packets):
+    for rows, cols, states in packets:
+        efft.update_arrays(rows, cols, states)
+
+
+def rate(feed, packets):
+    efft = eFFT(FRAME_SIZE)
+    efft.initialize()
+    start = time.perf_counter()
+    feed(efft, packets)
+    return PACKETS * PACKET_SIZE / (time.perf_counter() - start), efft
+
+
+def test_benchmark_update_arrays():
+    packets = generate_packets(0)
+    stimuli_rate, expected = rate(feed_stimuli, packets)
+    arrays_rate, efft = rate(feed_arrays, packets)
+    print(f"\nStimuli: {stimuli_rate / 1e6:.2f} Mev/s, update_arrays: {arrays_rate / 1e6:.2f} Mev/s")
+    np.testing.assert_array_equal(efft.get_fft(), expected.get_fft())
+
+
+@benchmark
+def test_benchmark_update_arrays_speedup():
+    packets = generate_packets(0)
+    rate(feed_arrays, packets)  # warm up
+    stimuli_rate, _ = rate(feed_stimuli, packets)
+    arrays_rate, _ = rate(feed_arrays, packets)
+    assert arrays_rate > 2 * stimuli_rate
+
+
+def test_benchmark_update_arrays_threads():
+    threads = 4
+    packets = [generate_packets(seed) for seed in range(threads)]
+    instances = [eFFT(FRAME_SIZE) for _ in range(threads)]
+    for efft in instances:
+        efft.initialize()
+
+    start = time.perf_counter()
+    for efft, p in zip(instances, packets):
+        feed_arrays(efft, p)
+    sequential = time.perf_counter() - start
+
+    for efft in instances:
+        efft.reset()
+    start = time.perf_counter()
+    with ThreadPoolExecutor(threads) as pool:
+        list(pool.map(feed_arrays, instances, packets))
+    parallel = time.perf_counter() - start
+    print(f"\n{threads} instances: sequential {sequential * 1e3:.1f} ms, threads {parallel * 1e3:.1f} ms")
+
+    for efft, p in zip(instances, packets):
+        expected = eFFT(FRAME_SIZE)
+        expected.initialize()
+        feed_arrays(expected, p)
+        np.testing.assert_array_equal(efft.get_fft(), expected.get_fft())
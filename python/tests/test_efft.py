@@ -1,5 +1,7 @@
 #!/usr/bin/env python3
+from concurrent.futures import ThreadPoolExecutor
 from efft import Stimulus, Stimuli, eFFT
+import gc
 import numpy as np
 import random
 
@@ -121,3 +123,121 @@ def test_efft():
 
             expected_fft = np.fft.fft2(gt)
             np.testing.assert_array_almost_equal(fft_result, expected_fft, decimal=1)
+
+
+def test_update_keeps_stimuli():
+    stimuli = Stimuli()
+    for row, col in [(3, 5), (6, 1), (7, 7), (2, 4)]:
+        stimuli.append(Stimulus(row, col, True))
+
+    efft1 = eFFT(8)
+    efft2 = eFFT(8)
+    efft1.initialize()
+    efft2.initialize()
+    assert efft1.update(stimuli)
+    assert efft2.update(stimuli)
+
+    assert [(s.row, s.col) for s in stimuli] == [(3, 5), (6, 1), (7, 7), (2, 4)]
+    np.testing.assert_array_almost_equal(efft1.get_fft(), efft2.get_fft())
+
+
+def test_reset():
+    stimuli = Stimuli()
+    for row, col in [(3, 5), (6, 1), (7, 7), (2, 4)]:
+        stimuli.append(Stimulus(row, col, True))
+
+    efft = eFFT(8)
+    efft.initialize()
+    assert efft.update(stimuli)
+    efft.reset()
+    np.testing.assert_array_equal(efft.get_fft(), np.zeros((8, 8)))
+    assert efft.update(stimuli)
+    np.testing.assert_array_almost_equal(efft.get_fft(), np.fft.fft2(np.isin(np.arange(64), [29, 49, 63, 20]).reshape(8, 8)))
+
+
+def test_spectrum_access():
+    stimuli = Stimuli()
+    for row, col in [(3, 5), (6, 1), (7, 7), (2, 4), (10, 12)]:
+        stimuli.append(Stimulus(row, col, True))
+
+    efft = eFFT(16)
+    efft.initialize()
+    efft.update(stimuli)
+    expected = efft.get_fft()
+
+    view = efft.get_fft_view()
+    assert view.shape == (16, 16)
+    assert not view.flags.writeable
+    np.testing.assert_array_equal(view, expected)
+    np.testing.assert_array_equal(efft.window(2, 3, 4, 5), expected[2:6, 3:8])
+    assert efft.bin(2, 3) == expected[2, 3]
+
+    out = np.zeros((4, 5), dtype=np.complex64)
+    efft.copy_to(out, 2, 3)
+    np.testing.assert_array_equal(out, expected[2:6, 3:8])
+
+    window = efft.window(2, 3, 4, 5)
+    assert window.strides == (8, 16 * 8)  # column-major view of the root
+    del efft
+    gc.collect()  # the views keep the engine alive
+    np.testing.assert_array_equal(view, expected)
+    np.testing.assert_array_equal(window, expected[2:6, 3:8])
+
+
+def test_update_arrays():
+    rng = np.random.default_rng(0)
+    rows = rng.integers(0, 32, 1000)
+    cols = rng.integers(0, 32, 1000)
+    states = rng.integers(0, 2, 1000).astype(bool)
+
+    stimuli = Stimuli()
+    for r, c, s in zip(rows, cols, states):
+        stimuli.append(Stimulus(int(r), int(c), bool(s)))
+    expected = eFFT(32)
+    expected.initialize()
+    expected.update(stimuli)
+
+    for dtype in [np.uint16, np.int32, np.int64]:
+        efft = eFFT(32)
+        efft.initialize()
+        assert efft.update_arrays(rows.astype(dtype), cols.astype(dtype), states)
+        np.testing.assert_array_equal(efft.get_fft(), expected.get_fft())
+
+        efft = eFFT(32)
+        efft.initialize()
+        assert efft.update_arrays(np.stack([rows, cols, states], axis=1).astype(dtype))
+        np.testing.assert_array_equal(efft.get_fft(), expected.get_fft())
+
+    efft = eFFT(32)
+    efft.initialize()
+    events = np.stack([rows, cols, states], axis=1)
+    assert efft.update_arrays(events[:, 0], events[:, 1], states)  # strided columns are read in place
+    np.testing.assert_array_equal(efft.get_fft(), expected.get_fft())
+
+    try:
+        efft.update_arrays(np.array([32]), np.array([0]), np.array([True]))
+        assert False
+    except IndexError:
+        pass
+    try:
+        efft.update_arrays(np.array([0, 1]), np.array([0]), np.array([True]))
+        assert False
+    except ValueError:
+        pass
+
+
+def test_update_arrays_shared():
+    rng = np.random.default_rng(1)
+    packets = [(rng.integers(0, 64, 2000), rng.integers(0, 64, 2000)) for _ in range(16)]
+    ones = np.ones(2000, dtype=bool)  # only turning pixels on, so the result does not depend on the order
+
+    expected = eFFT(64)
+    expected.initialize()
+    for rows, cols in packets:
+        expected.update_arrays(rows, cols, ones)
+
+    efft = eFFT(64)
+    efft.initialize()
+    with ThreadPoolExecutor(4) as pool:
+        list(pool.map(lambda p: efft.update_arrays(p[0], p[1], ones), packets))
+    np.testing.assert_allclose(efft.get_fft(), expected.get_fft(), atol=1e-3)
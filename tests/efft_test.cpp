@@ -1,11 +1,49 @@
 #include "efft.hpp"
+#include "efft_reader.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <new>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 
 constexpr unsigned int NTEST = 25;
 
+static std::atomic<std::size_t> allocations{0};
+
+// counts every allocation of the binary; GCC flags the free() in the replaced delete once new is inlined next to it
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void *operator new(const std::size_t size) {
+  allocations++;
+  if(void *p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+  allocations++;
+  const auto a = static_cast<std::size_t>(alignment);
+  if(void *p = std::aligned_alloc(a, (size + a - 1) / a * a)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
 template <unsigned int N>
 class RandEventGenerator {
 public:
@@ -76,6 +114,34 @@ TEST(StimuliTest, Filter) {
   ASSERT_EQ(ss.size(), 3 + 3);
 }
 
+TEST(StimuliTest, FilterFramesize) {
+  Stimuli ss;
+  for(unsigned int i = 0; i < 1000; i++) {
+    ss.emplace_back((i * 7U) % 13U, (i * 11U) % 16U, (i % 3U) == 0);
+  }
+  Stimuli expected = ss;
+  expected.filter();
+  ss.filter(16);
+
+  ASSERT_EQ(ss.size(), expected.size());
+  for(std::size_t i = 0; i < ss.size(); i++) {
+    ASSERT_EQ(ss[i], expected[i]);
+    ASSERT_EQ(ss[i].state, expected[i].state);
+  }
+
+  Stimuli wrapped;
+  wrapped.emplace_back(3, 5, false);
+  wrapped.emplace_back(19, 5, true);
+  wrapped.emplace_back(3, 1000005, false);
+  wrapped.emplace_back(4000000000U, 4, false);
+  wrapped.filter(16);
+
+  ASSERT_EQ(wrapped.size(), 2U);
+  ASSERT_EQ(wrapped[0], Stimulus(3, 5));
+  ASSERT_EQ(wrapped[0].state, true);
+  ASSERT_EQ(wrapped[1], Stimulus(4000000000U, 4));
+}
+
 TEST(StimuliTest, State) {
   Stimuli ss;
   ss.emplace_back(231, 451, true);
@@ -94,6 +160,695 @@ TEST(StimuliTest, State) {
   }
 }
 
+template <typename Format>
+static void CompactFormat(const float epsilon) {
+  for(const float x : {0.0F, 1.0F, -1.0F, 0.5F, 3.0F, -64.0F, 1024.0F}) {
+    ASSERT_EQ(Format::decode(Format::encode(x)), x);
+  }
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dis(-4096.0F, 4096.0F);
+  std::vector<float> x(1001);
+  for(float &v : x) {
+    v = dis(gen);
+  }
+  std::vector<uint16_t> h(x.size());
+  std::vector<float> y(x.size());
+  Format::encode(x.data(), h.data(), x.size());
+  Format::decode(h.data(), y.data(), h.size());
+  for(std::size_t k = 0; k < x.size(); k++) {
+    ASSERT_EQ(h[k], Format::encode(x[k]));
+    ASSERT_EQ(y[k], Format::decode(h[k]));
+    ASSERT_LE(std::abs(y[k] - x[k]), epsilon * std::abs(x[k]));
+  }
+}
+TEST(CompactTest, Formats) {
+  CompactFormat<bfloat16>(1.0F / 256);
+  CompactFormat<float16>(1.0F / 1024);
+  ASSERT_EQ(bfloat16::encode(1.0F + 1.0F / 256), bfloat16::encode(1.0F)); // ties to even
+  ASSERT_EQ(float16::encode(1.0F + 1.0F / 2048), float16::encode(1.0F));
+  ASSERT_EQ(float16::decode(float16::encode(65504.0F)), 65504.0F);
+  ASSERT_EQ(float16::encode(65536.0F), 0x7C00); // overflows to infinity
+  ASSERT_EQ(float16::decode(float16::encode(std::ldexp(1.0F, -24))), std::ldexp(1.0F, -24)); // smallest subnormal
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT>
+static void FeedWindow(const uint64_t window) {
+  eFFTWindow<WIDTH, HEIGHT> windowed(window);
+  eFFT<WIDTH, HEIGHT> reference;
+  std::vector<int64_t> last(WIDTH * HEIGHT, -1);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<unsigned int> cols(0, WIDTH - 1);
+  std::uniform_int_distribution<unsigned int> rows(0, HEIGHT - 1);
+  std::uniform_int_distribution<unsigned int> size(1, 200);
+  std::uniform_int_distribution<unsigned int> step(0, 20);
+
+  uint64_t t = 0;
+  TimedStimuli ss;
+  for(unsigned int test = 0; test < 4 * NTEST; test++) {
+    ss.clear();
+    for(unsigned int k = size(gen); k > 0; k--) {
+      t += step(gen);
+      ss.emplace_back(rows(gen), cols(gen), t, step(gen) > 1);
+      last[ss.back().row * WIDTH + ss.back().col] = ss.back().state ? static_cast<int64_t>(t) : -1;
+    }
+    if(test % 2 == 0) {
+      windowed.update(ss);
+    } else {
+      for(const TimedStimulus &s : ss) {
+        windowed.update(s);
+      }
+    }
+    if(test % 10 == 9) {
+      t += window / 2;
+      windowed.advance(t);
+    }
+
+    cfloatmat image(cfloatmat::Zero(HEIGHT, WIDTH));
+    std::size_t active = 0;
+    for(unsigned int pixel = 0; pixel < WIDTH * HEIGHT; pixel++) {
+      if(last[pixel] >= 0 && t - static_cast<uint64_t>(last[pixel]) < window) {
+        image(pixel / WIDTH, pixel % WIDTH) = 1;
+        active++;
+      }
+    }
+    reference.initialize(image);
+    ASSERT_EQ(windowed.now(), t);
+    ASSERT_EQ(windowed.active(), active);
+    ASSERT_LT((windowed.getFFT() - reference.getFFT()).norm(), 0.1);
+  }
+
+  windowed.advance(t + window);
+  ASSERT_EQ(windowed.active(), 0);
+  ASSERT_LT(windowed.getFFT().norm(), 0.1);
+}
+TEST(eFFTWindowTest, Feed) {
+  FeedWindow<64, 64>(500);
+  FeedWindow<64, 32>(2000);
+  FeedWindow<16, 128>(100);
+  FeedWindow<32, 32>(0);
+}
+
+TEST(eFFTLazyTest, ConcurrentReaders) {
+  constexpr unsigned int N = 128;
+  RandEventGenerator<N> rand;
+  eFFT<N> lazy;
+  eFFT<N> reference;
+  lazy.setLazy(true);
+  for(unsigned int k = 0; k < 10; k++) {
+    const Stimuli ss = rand.next(500U);
+    lazy.update(ss);
+    reference.update(ss);
+    const eFFT<N> &view = lazy; // only const accessors, which flush the pending updates
+    std::vector<double> errors(4);
+    std::vector<std::thread> readers;
+    for(unsigned int t = 0; t < errors.size(); t++) {
+      readers.emplace_back([&view, &reference, &errors, t] {
+        errors[t] = (view.getFFT() - reference.getFFT()).norm() + std::abs(view.bin(1, 2) - reference.bin(1, 2));
+      });
+    }
+    for(std::thread &t : readers) {
+      t.join();
+    }
+    for(const double error : errors) {
+      ASSERT_LT(error, 1e-2);
+    }
+  }
+}
+
+template <unsigned int FRAME_SIZE>
+static void ConstructConcurrently(const unsigned int threads) {
+  RandEventGenerator<FRAME_SIZE> rand;
+  const Stimuli ss = rand.next(1000U);
+  eFFT<FRAME_SIZE> reference;
+  reference.update(ss);
+
+  std::vector<double> errors(threads);
+  std::vector<std::thread> pool;
+  for(unsigned int k = 0; k < threads; k++) {
+    pool.emplace_back([&ss, &reference, &errors, k] {
+      eFFT<FRAME_SIZE, FRAME_SIZE, eFFTHalfSpectrumTraits> half; // first instance of this type, builds its tables here
+      eFFT<FRAME_SIZE> full;
+      half.update(ss);
+      full.update(ss);
+      errors[k] = (half.getFullFFT() - reference.getFFT()).norm() + (full.getFFT() - reference.getFFT()).norm();
+    });
+  }
+  for(std::thread &t : pool) {
+    t.join();
+  }
+  for(const double error : errors) {
+    ASSERT_LT(error, 0.1);
+  }
+}
+TEST(eFFTSharedTest, ConstructConcurrently) {
+  ConstructConcurrently<32>(8);
+  ConstructConcurrently<256>(4);
+}
+TEST(eFFTSharedTest, WrapOutOfFrame) {
+  eFFT<64, 32> efft;
+  eFFT<64, 32> wrapped;
+  efft.setDeduplicate(true);
+  ASSERT_TRUE(efft.update(Stimulus(32 + 3, 64 + 5, true))); // wraps to (3, 5)
+  ASSERT_FALSE(efft.update(Stimulus(3, 5, true)));
+  Stimuli ss;
+  ss.emplace_back(1000, 1000, true);
+  ss.emplace_back(8, 40, true); // same pixel
+  ss.emplace_back(7, 9, true);
+  ASSERT_TRUE(efft.update(ss));
+  wrapped.update(Stimulus(3, 5, true));
+  wrapped.update(Stimulus(8, 40, true));
+  wrapped.update(Stimulus(7, 9, true));
+  ASSERT_EQ((efft.getFFT() - wrapped.getFFT()).norm(), 0);
+  efft.setPropagation(Propagation::Delta);
+  wrapped.setPropagation(Propagation::Delta);
+  ASSERT_TRUE(efft.update(Stimulus(32 + 1, 128 + 2, true)));
+  wrapped.update(Stimulus(1, 2, true));
+  ASSERT_LT((efft.getFFT() - wrapped.getFFT()).norm(), 1e-3);
+
+  eFFTWindow<64, 32> windowed(100);
+  windowed.update(TimedStimulus(32 + 3, 64 + 5, 0));
+  ASSERT_EQ(windowed.active(), 1U);
+  ASSERT_EQ(windowed.getFFT()(0, 0), cfloat(1, 0));
+  windowed.advance(100);
+  ASSERT_EQ(windowed.active(), 0U);
+}
+
+template <unsigned int B, unsigned int R, unsigned int COMPACT>
+struct ResetTraits : eFFTTraits {
+  static constexpr unsigned int LEAF_BLOCK = B;
+  static constexpr unsigned int RADIX = R;
+  static constexpr unsigned int COMPACT_LEVELS = COMPACT;
+};
+
+template <unsigned int FRAME_SIZE, typename Traits = eFFTTraits>
+static void ResetInPlace(const bool lazy) {
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> efft;
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> fresh;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.setLazy(lazy);
+  for(unsigned int test = 0; test < NTEST; test++) {
+    efft.setPropagation(test % 2 ? Propagation::Delta : Propagation::Tree);
+    efft.update(rand.next());
+    efft.update(rand.next(test * 10));
+  }
+  efft.reset();
+  ASSERT_EQ(efft.getFFT().norm(), 0);
+
+  const Stimuli ss = rand.next(100U);
+  efft.update(ss);
+  fresh.update(ss);
+  ASSERT_EQ((efft.getFFT() - fresh.getFFT()).norm(), 0);
+  efft.reset();
+  efft.reset();
+  ASSERT_EQ(efft.getFFT().norm(), 0);
+  ASSERT_FALSE(efft.update(Stimulus(0, 0, false)));
+}
+TEST(eFFTResetTest, ResetInPlace) {
+  ResetInPlace<1>(false);
+  ResetInPlace<64>(false);
+  ResetInPlace<64>(true);
+  ResetInPlace<128, eFFTHalfSpectrumTraits>(false);
+  ResetInPlace<128, ResetTraits<8, 2, 0>>(false);
+  ResetInPlace<128, ResetTraits<1, 4, 3>>(true);
+  ResetInPlace<64, ResetTraits<4, 2, 4>>(false);
+}
+
+template <unsigned int FRAME_SIZE, typename Traits = eFFTTraits>
+static void UpdateWithoutAllocations(const bool lazy, const bool deduplicate) {
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> efft;
+  eFFTWindow<FRAME_SIZE, FRAME_SIZE, Traits> windowed(500);
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.setLazy(lazy);
+  efft.setDeduplicate(deduplicate);
+  const Stimuli ss = rand.next(5000U);
+  TimedStimuli ts;
+  for(std::size_t k = 0; k < ss.size(); k++) {
+    ts.emplace_back(ss[k].row, ss[k].col, k, ss[k].state);
+  }
+
+  std::size_t count = 0;
+  for(unsigned int pass = 0; pass < 2; pass++) { // the first pass grows the internal buffers
+    const std::size_t before = allocations;
+    for(std::size_t k = 0; k + 100 <= ss.size(); k += 100) {
+      efft.setPropagation(k % 200 ? Propagation::Delta : Propagation::Tree);
+      efft.update(ss[k]);
+      efft.update(ss.data() + k, 100);
+      windowed.update(ts.data() + k, 100);
+      [[maybe_unused]] auto result = efft.getFFT();
+    }
+    efft.reset();
+    windowed.reset();
+    count = allocations - before;
+  }
+  ASSERT_EQ(count, 0);
+}
+TEST(eFFTResetTest, UpdateWithoutAllocations) {
+  UpdateWithoutAllocations<64>(false, false);
+  UpdateWithoutAllocations<64>(true, false);
+  UpdateWithoutAllocations<64>(false, true);
+  UpdateWithoutAllocations<128, eFFTHalfSpectrumTraits>(false, false);
+  UpdateWithoutAllocations<128, ResetTraits<8, 2, 0>>(true, true);
+  UpdateWithoutAllocations<128, ResetTraits<1, 4, 3>>(false, false);
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT, typename Traits = eFFTTraits>
+static void SaveAndLoad() {
+  eFFT<WIDTH, HEIGHT, Traits> efft;
+  eFFT<WIDTH, HEIGHT, Traits> restored;
+  eFFT<WIDTH, HEIGHT, Traits> mapped;
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+  const auto next = [&cols, &rows](const unsigned int n) {
+    Stimuli ss;
+    for(unsigned int k = 0; k < n; k++) {
+      const Stimulus s = cols.next();
+      ss.emplace_back(rows.next().row, s.col, s.state);
+    }
+    return ss;
+  };
+  efft.setLazy(true);
+  efft.update(next(WIDTH * HEIGHT / 2));
+
+  std::stringstream stream;
+  ASSERT_TRUE(efft.save(stream));
+  const std::string snapshot = stream.str();
+  ASSERT_EQ(snapshot.size(), efft.snapshotSize());
+  ASSERT_TRUE(restored.load(stream));
+  ASSERT_TRUE(mapped.load(snapshot.data(), snapshot.size()));
+  ASSERT_FALSE(mapped.load(snapshot.data(), snapshot.size() - 1));
+  ASSERT_EQ((restored.getFFT() - efft.getFFT()).norm(), 0);
+  ASSERT_EQ((mapped.getFFT() - efft.getFFT()).norm(), 0);
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimuli ss = next(100);
+    ASSERT_EQ(efft.update(ss), restored.update(ss));
+    mapped.update(ss);
+    const Stimulus s = Stimulus(ss[0]).toggle();
+    ASSERT_EQ(efft.update(s), mapped.update(s));
+    restored.update(s);
+  }
+  ASSERT_EQ((restored.getFFT() - efft.getFFT()).norm(), 0);
+  ASSERT_EQ((mapped.getFFT() - efft.getFFT()).norm(), 0);
+}
+TEST(eFFTSnapshotTest, SaveAndLoad) {
+  SaveAndLoad<64, 64>();
+  SaveAndLoad<128, 32>();
+  SaveAndLoad<128, 128, eFFTHalfSpectrumTraits>();
+  SaveAndLoad<128, 128, ResetTraits<4, 4, 2>>();
+}
+TEST(eFFTSnapshotTest, Incompatible) {
+  eFFT<64> efft;
+  efft.update(Stimulus(1, 2));
+  std::stringstream stream;
+  ASSERT_TRUE(efft.save(stream));
+  const std::string snapshot = stream.str();
+
+  eFFT<32> smaller;
+  eFFT<64, 64, eFFTHalfSpectrumTraits> half;
+  ASSERT_FALSE(smaller.load(snapshot.data(), snapshot.size()));
+  ASSERT_FALSE(half.load(snapshot.data(), snapshot.size()));
+  std::string corrupted = snapshot;
+  corrupted[8]++; // version
+  eFFT<64> other;
+  ASSERT_FALSE(other.load(corrupted.data(), corrupted.size()));
+  std::stringstream truncated(snapshot.substr(0, snapshot.size() / 2));
+  other.update(Stimulus(3, 4));
+  ASSERT_FALSE(other.load(truncated));
+  ASSERT_EQ(other.getFFT().norm(), 0);
+
+  const std::string path = ::testing::TempDir() + "efft_snapshot.bin";
+  ASSERT_TRUE(efft.save(path));
+  ASSERT_TRUE(other.load(path));
+  ASSERT_EQ((other.getFFT() - efft.getFFT()).norm(), 0);
+  std::remove(path.c_str());
+  ASSERT_FALSE(other.load(path));
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT, typename Traits = eFFTTraits>
+static void ReadSpectrum() {
+  eFFT<WIDTH, HEIGHT, Traits> efft;
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+  Stimuli ss;
+  for(unsigned int k = 0; k < WIDTH * HEIGHT / 2; k++) {
+    ss.emplace_back(rows.next().row, cols.next().col, true);
+  }
+  efft.setLazy(true);
+  efft.update(ss);
+  const auto full = efft.getFullFFT();
+  const auto x = efft.getFFT();
+  ASSERT_EQ(x.cols(), efft.spectrumCols());
+
+  for(unsigned int u = 0; u < HEIGHT; u++) {
+    for(unsigned int v = 0; v < WIDTH; v++) {
+      ASSERT_EQ(efft.bin(u, v), full(u, v));
+    }
+  }
+
+  const unsigned int u0 = HEIGHT / 4;
+  const unsigned int v0 = efft.spectrumCols() / 4;
+  const unsigned int n = HEIGHT / 2;
+  const unsigned int m = efft.spectrumCols() / 2;
+  const auto window = efft.window(u0, v0, n, m);
+  ASSERT_EQ(window.data(), x.data() + u0 + v0 * HEIGHT); // no copy
+  ASSERT_EQ(window, x.block(u0, v0, n, m));
+
+  std::vector<cfloat> out(n * m);
+  std::vector<float> real(n * m);
+  std::vector<float> imag(n * m);
+  efft.copyTo(out.data(), u0, v0, n, m);
+  efft.copyTo(real.data(), imag.data(), u0, v0, n, m);
+  for(unsigned int i = 0; i < n; i++) {
+    for(unsigned int j = 0; j < m; j++) {
+      ASSERT_EQ(out[i * m + j], x(u0 + i, v0 + j));
+      ASSERT_EQ(real[i * m + j], x(u0 + i, v0 + j).real());
+      ASSERT_EQ(imag[i * m + j], x(u0 + i, v0 + j).imag());
+    }
+  }
+  std::vector<cfloat> all(HEIGHT * efft.spectrumCols());
+  efft.copyTo(all.data());
+  ASSERT_EQ(all.back(), x(HEIGHT - 1, efft.spectrumCols() - 1));
+}
+TEST(eFFTAccessTest, ReadSpectrum) {
+  ReadSpectrum<64, 64>();
+  ReadSpectrum<64, 16>();
+  ReadSpectrum<64, 64, eFFTHalfSpectrumTraits>();
+  ReadSpectrum<32, 128, eFFTHalfSpectrumTraits>();
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT, typename Traits = eFFTTraits>
+static void DerivedOutputs(const bool lazy, const Propagation propagation, const unsigned int threads = 1) {
+  eFFT<WIDTH, HEIGHT, Traits> efft;
+  const std::vector<double> edges{0.0, 0.05, 0.15, 0.3, 0.5};
+  efft.setFeatures(true, edges);
+  efft.setLazy(lazy);
+  efft.setPropagation(propagation);
+  efft.setThreads(threads);
+  efft.setParallelCombine(threads > 1 ? 16 : 0);
+  ASSERT_EQ(efft.bands(), edges.size() - 1);
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+
+  const auto check = [&] {
+    const auto x = efft.getFFT();
+    ASSERT_LT((efft.getPower() - x.cwiseAbs2()).norm(), 1e-5 * (1 + x.cwiseAbs2().norm()));
+    const auto full = efft.getFullFFT();
+    std::vector<double> expected(efft.bands(), 0.0);
+    double total = 0;
+    for(unsigned int u = 0; u < HEIGHT; u++) {
+      for(unsigned int v = 0; v < WIDTH; v++) {
+        const double e = std::norm(full(u, v));
+        const double fu = static_cast<double>(std::min(u, HEIGHT - u)) / HEIGHT;
+        const double fv = static_cast<double>(std::min(v, WIDTH - v)) / WIDTH;
+        const auto k = std::upper_bound(edges.begin(), edges.end(), std::sqrt(fu * fu + fv * fv)) - edges.begin() - 1;
+        if(k >= 0 && k < static_cast<int>(expected.size())) {
+          expected[k] += e;
+        }
+        total += e;
+      }
+    }
+    ASSERT_NEAR(efft.totalEnergy(), total, 1e-5 * total);
+    ASSERT_NEAR(efft.totalEnergy(), static_cast<double>(WIDTH * HEIGHT) * efft.dc().real(), 1e-2 * total); // Parseval, up to the accuracy of compact levels
+    for(std::size_t k = 0; k < expected.size(); k++) {
+      ASSERT_NEAR(efft.bandEnergy(k), expected[k], 1e-5 * total);
+    }
+  };
+
+  for(unsigned int k = 0; k < 4; k++) {
+    Stimuli ss;
+    for(unsigned int i = 0; i < WIDTH * HEIGHT / 8; i++) {
+      ss.emplace_back(rows.next().row, cols.next().col, k != 2);
+    }
+    efft.update(ss);
+    check();
+    efft.update(Stimulus(rows.next().row, cols.next().col, true));
+    check();
+  }
+  ASSERT_GT(efft.totalEnergy(), 0);
+  efft.reset();
+  check();
+  ASSERT_EQ(efft.totalEnergy(), 0);
+  efft.setFeatures(false);
+  ASSERT_EQ(efft.getPower().size(), 0);
+}
+TEST(eFFTFeatureTest, DerivedOutputs) {
+  DerivedOutputs<64, 64>(false, Propagation::Tree);
+  DerivedOutputs<64, 64>(true, Propagation::Tree);
+  DerivedOutputs<64, 64>(false, Propagation::Delta);
+  DerivedOutputs<128, 32>(false, Propagation::Tree);
+  DerivedOutputs<64, 64>(false, Propagation::Tree, 4);
+  DerivedOutputs<64, 64, eFFTHalfSpectrumTraits>(false, Propagation::Tree);
+  DerivedOutputs<64, 64, eFFTHalfSpectrumTraits>(false, Propagation::Tree, 4);
+  DerivedOutputs<64, 16, eFFTHalfSpectrumTraits>(true, Propagation::Tree);
+  DerivedOutputs<64, 64, ResetTraits<4, 4, 0>>(false, Propagation::Tree);
+  DerivedOutputs<128, 128, ResetTraits<8, 2, 2>>(false, Propagation::Tree);
+}
+
+template <unsigned int FRAME_SIZE, typename Traits>
+static void CompactParallel() {
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> serial;
+  eFFT<FRAME_SIZE, FRAME_SIZE, Traits> parallel;
+  RandEventGenerator<FRAME_SIZE> rand;
+  parallel.setThreads(4, 3);
+  parallel.setParallelCombine(4); // smaller than the compact nodes
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimuli ss = rand.next(1000U);
+    ASSERT_EQ(serial.update(ss), parallel.update(ss));
+    ASSERT_EQ(serial.update(ss[0]), parallel.update(ss[0]));
+  }
+  ASSERT_EQ(parallel.getFFT(), serial.getFFT()); // the same butterflies in the same order
+}
+TEST(eFFTParallelTest, CompactParallel) {
+  CompactParallel<64, ResetTraits<1, 2, 4>>();
+  CompactParallel<128, ResetTraits<4, 2, 3>>();
+  CompactParallel<128, ResetTraits<1, 4, 4>>();
+}
+
+TEST(eFFTPipelineTest, Feed) {
+  constexpr unsigned int N = 64;
+  eFFTPipeline<N> pipeline(256, 64);
+  eFFT<N> reference;
+  RandEventGenerator<N> gen;
+
+  std::atomic<bool> done{false};
+  std::atomic<bool> torn{false};
+  std::thread reader([&] {
+    eFFTPipeline<N>::matrix x;
+    uint64_t last = 0;
+    while(!done.load()) {
+      const uint64_t version = pipeline.snapshot(x);
+      torn = torn || version < last;
+      last = version;
+      for(unsigned int u = 0; u < N; u++) { // a snapshot mixing two states would not be conjugate-symmetric
+        for(unsigned int v = 0; v < N; v++) {
+          torn = torn || std::abs(x(u, v) - std::conj(x((N - u) % N, (N - v) % N))) > 1e-2F;
+        }
+      }
+    }
+  });
+
+  eFFTPipeline<N>::matrix x;
+  for(const bool state : {true, false, true}) {
+    const Stimuli ss = gen.next(N * N, state);
+    std::size_t queued = 0;
+    while(queued < ss.size()) { // retry what does not fit
+      queued += pipeline.push(ss.data() + queued, ss.size() - queued);
+    }
+    reference.update(ss);
+    pipeline.drain();
+    pipeline.snapshot(x);
+    EXPECT_LT((x - reference.getFFT()).norm(), 1e-3); // not fatal while the reader runs
+  }
+  done = true;
+  reader.join();
+  ASSERT_FALSE(torn);
+
+  pipeline.stop(); // nothing drains the ring, so what does not fit is dropped
+  const Stimuli overflow = gen.next(1024U);
+  const std::size_t dropped = pipeline.dropped();
+  const std::size_t queued = pipeline.push(overflow);
+  ASSERT_LE(queued, 256U);
+  ASSERT_EQ(pipeline.dropped() - dropped, overflow.size() - queued);
+  pipeline.start();
+  pipeline.drain();
+
+  pipeline.stop();
+  pipeline.engine().reset();
+  pipeline.start();
+  ASSERT_EQ(pipeline.snapshot(x), pipeline.version());
+  ASSERT_EQ(x.norm(), 0);
+}
+
+static TimedStimuli RandTimedEvents(const std::size_t count, const unsigned int width, const unsigned int height) {
+  std::mt19937 gen(42);
+  TimedStimuli events;
+  uint64_t t = 0;
+  for(std::size_t k = 0; k < count; k++) {
+    t += gen() % 50;
+    events.emplace_back(gen() % height, gen() % width, t, gen() % 2 == 1);
+  }
+  return events;
+}
+template <typename T>
+static void Append(std::string &file, const T word, const bool big = false) {
+  for(unsigned int i = 0; i < sizeof(T); i++) {
+    file.push_back(static_cast<char>(word >> (8 * (big ? sizeof(T) - 1 - i : i))));
+  }
+}
+static void ReadBack(EventReader &reader, const TimedStimuli &expected) {
+  TimedStimuli packet;
+  std::size_t k = 0;
+  while(reader.read(packet, 7)) {
+    ASSERT_LE(packet.size(), 7U);
+    for(const TimedStimulus &e : packet) {
+      ASSERT_LT(k, expected.size());
+      ASSERT_EQ(e, expected[k]);
+      ASSERT_EQ(e.t, expected[k].t);
+      ASSERT_EQ(e.state, expected[k++].state);
+    }
+  }
+  ASSERT_EQ(k, expected.size());
+}
+TEST(EventReaderTest, Packed) {
+  const TimedStimuli events = RandTimedEvents(10000, 640, 480);
+  const std::string path = ::testing::TempDir() + "efft_events.bin";
+  ASSERT_TRUE(writePackedEvents(path, events.data(), events.size(), 640, 480));
+  std::ifstream is(path, std::ios::binary);
+  const std::string bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  std::string expected(PackedEvent::MAGIC, sizeof(PackedEvent::MAGIC));
+  Append<uint32_t>(expected, 640);
+  Append<uint32_t>(expected, 480);
+  Append<uint64_t>(expected, PackedEvent::encode(events[0].t, events[0].col, events[0].row, events[0].state));
+  ASSERT_EQ(bytes.size(), PackedEvent::HEADER_SIZE + events.size() * sizeof(uint64_t));
+  ASSERT_EQ(bytes.substr(0, expected.size()), expected); // little-endian on any host
+  EventReader reader(path, EventFormat::Packed);
+  ASSERT_TRUE(reader.isOpen());
+  ASSERT_EQ(reader.width(), 640U);
+  ASSERT_EQ(reader.height(), 480U);
+  ReadBack(reader, events);
+
+  reader.rewind();
+  TimedStimuli packet;
+  std::size_t k = 0;
+  while(reader.readFor(packet, 1000)) {
+    ASSERT_LT(packet.back().t - packet.front().t, 1000);
+    ASSERT_EQ(packet.front(), events[k]);
+    k += packet.size();
+    ASSERT_TRUE(k == events.size() || events[k].t >= packet.front().t + 1000);
+  }
+  ASSERT_EQ(k, events.size());
+
+  eFFT<512> efft;
+  eFFT<512> reference;
+  Stimuli stimuli;
+  reader.rewind();
+  reader.setFrame(512, 512);
+  while(reader.read(stimuli, 256)) {
+    efft.update(stimuli);
+  }
+  stimuli.clear();
+  for(const TimedStimulus &e : events) {
+    if(e.col < 512) {
+      stimuli.emplace_back(e.row, e.col, e.state);
+    }
+    if(stimuli.size() == 256 || &e == &events.back()) {
+      reference.update(stimuli);
+      stimuli.clear();
+    }
+  }
+  ASSERT_EQ((efft.getFFT() - reference.getFFT()).norm(), 0);
+
+  std::remove(path.c_str());
+  TimedStimuli outside = events;
+  outside.back().col = PackedEvent::COORD_LIMIT;
+  ASSERT_FALSE(writePackedEvents(path, outside.data(), outside.size(), 640, 480));
+  ASSERT_FALSE(reader.open(path, EventFormat::Packed));
+  ASSERT_EQ(PackedEvent::encode((uint64_t{1} << PackedEvent::TIME_BITS) + 5, PackedEvent::COORD_LIMIT + 1, 2, true), PackedEvent::encode(5, 1, 2, true));
+  ASSERT_FALSE(reader.open(path.data(), path.size(), EventFormat::Packed));
+}
+TEST(EventReaderTest, Encoded) {
+  const TimedStimuli events = RandTimedEvents(1000, 1280, 720);
+  std::string evt2 = "% evt 2.0\n% geometry 1280x720\n% end\n";
+  std::string evt3 = "% evt 3.0\n% format EVT3;height=720;width=1280\n% end\n";
+  std::string aedat = "#!AER-DAT2.0\n";
+  for(const TimedStimulus &e : events) {
+    Append<uint32_t>(evt2, (0x8U << 28U) | static_cast<uint32_t>(e.t >> 6U));
+    Append<uint32_t>(evt2, (static_cast<uint32_t>(e.state) << 28U) | static_cast<uint32_t>((e.t & 0x3FU) << 22U) | (e.col << 11U) | e.row);
+    Append<uint16_t>(evt3, static_cast<uint16_t>((0x8U << 12U) | ((e.t >> 12U) & 0xFFFU)));
+    Append<uint16_t>(evt3, static_cast<uint16_t>((0x6U << 12U) | (e.t & 0xFFFU)));
+    Append<uint16_t>(evt3, static_cast<uint16_t>(e.row));
+    Append<uint16_t>(evt3, static_cast<uint16_t>((0x2U << 12U) | (static_cast<uint32_t>(e.state) << 11U) | e.col));
+    Append<uint32_t>(aedat, 0x80000000U, true); // APS sample
+    Append<uint32_t>(aedat, static_cast<uint32_t>(e.t), true);
+    Append<uint32_t>(aedat, ((e.row & 0x1FFU) << 22U) | ((e.col & 0x3FFU) << 12U) | (static_cast<uint32_t>(e.state) << 11U), true);
+    Append<uint32_t>(aedat, static_cast<uint32_t>(e.t), true);
+  }
+  TimedStimuli clipped;
+  for(const TimedStimulus &e : events) {
+    clipped.emplace_back(e.row & 0x1FFU, e.col & 0x3FFU, e.t, e.state);
+  }
+
+  EventReader reader;
+  ASSERT_TRUE(reader.open(evt2.data(), evt2.size(), EventFormat::EVT2));
+  ASSERT_EQ(reader.width(), 1280U);
+  ASSERT_EQ(reader.height(), 720U);
+  ReadBack(reader, events);
+  ASSERT_TRUE(reader.open(evt3.data(), evt3.size(), EventFormat::EVT3));
+  ASSERT_EQ(reader.width(), 1280U);
+  ReadBack(reader, events);
+  ASSERT_TRUE(reader.open(aedat.data(), aedat.size(), EventFormat::AEDAT2));
+  ReadBack(reader, clipped);
+
+  std::string vector = "% end\n";
+  Append<uint16_t>(vector, 0x8000U | 0xFFFU); // time high about to wrap around
+  Append<uint16_t>(vector, 0x6000U | 5U);
+  Append<uint16_t>(vector, 10U);                                    // y
+  Append<uint16_t>(vector, (0x3U << 12U) | (1U << 11U) | 100U);     // base x, on
+  Append<uint16_t>(vector, (0x4U << 12U) | 0x801U);                 // x = 100, 111
+  Append<uint16_t>(vector, (0x5U << 12U) | 0x0FFU);                 // x = 112..119
+  Append<uint16_t>(vector, 0x8000U);                                // wrapped
+  Append<uint16_t>(vector, 0xA000U);                                // trigger
+  Append<uint16_t>(vector, (0x2U << 12U) | 7U);                     // x = 7, off
+  TimedStimuli expected;
+  const uint64_t t0 = (uint64_t{0xFFF} << 12U) | 5U;
+  expected.emplace_back(10, 100, t0, true);
+  expected.emplace_back(10, 111, t0, true);
+  for(unsigned int x = 112; x < 120; x++) {
+    expected.emplace_back(10, x, t0, true);
+  }
+  expected.emplace_back(10, 7, (uint64_t{1} << 24U) | 5U, false);
+  ASSERT_TRUE(reader.open(vector.data(), vector.size(), EventFormat::EVT3));
+  ReadBack(reader, expected);
+
+  std::string wrapped = "% end\n";
+  Append<uint32_t>(wrapped, (0x8U << 28U) | 0x0FFFFFFFU); // time high about to wrap around
+  Append<uint32_t>(wrapped, (0x1U << 28U) | (63U << 22U) | (4U << 11U) | 3U);
+  Append<uint32_t>(wrapped, 0x8U << 28U); // wrapped
+  Append<uint32_t>(wrapped, (2U << 22U) | (4U << 11U) | 3U);
+  expected.clear();
+  expected.emplace_back(3, 4, (uint64_t{1} << 34U) - 1, true);
+  expected.emplace_back(3, 4, (uint64_t{1} << 34U) + 2, false);
+  ASSERT_TRUE(reader.open(wrapped.data(), wrapped.size(), EventFormat::EVT2));
+  ReadBack(reader, expected);
+
+  std::string late = "#!AER-DAT2.0\n";
+  expected.clear();
+  for(const auto &[t, aps] : {std::pair<uint32_t, bool>{1000, false}, {900, true}, {1010, false}, {1005, false}, {0xFFFFFF00U, false}, {800, true}, {20, false}}) {
+    Append<uint32_t>(late, aps ? 0x80000000U : (3U << 22U) | (4U << 12U), true);
+    Append<uint32_t>(late, t, true);
+    if(!aps) { // samples and slightly late events do not wrap the time around
+      expected.emplace_back(3, 4, t < 1000 ? (uint64_t{1} << 32U) + t : t, false);
+    }
+  }
+  ASSERT_TRUE(reader.open(late.data(), late.size(), EventFormat::AEDAT2));
+  ReadBack(reader, expected);
+
+  for(const std::string header : {"% format EVT3;height=;width=1280\n", "% format EVT3;height=-1;width=1280\n", "% format EVT3;height=720;width=99999999999\n", "% geometry 1280\n", "% geometry x720\n"}) {
+    ASSERT_FALSE(reader.open(header.data(), header.size(), EventFormat::EVT3)) << header;
+    ASSERT_FALSE(reader.isOpen());
+  }
+}
+
 #ifdef EFFT_USE_FFTW3
 class eFFTTest : public ::testing::TestWithParam<unsigned int> {
 };
@@ -214,5 +969,441 @@ TEST_P(eFFTTest, FeedWithTheSamePacket) {
   FeedWithTheSamePacket<256>(p);
 }
 
+template <unsigned int FRAME_SIZE>
+static void FeedWithRedundantPackets() {
+  eFFT<FRAME_SIZE> efft;
+  efft.initialize();
+  efft.initializeGroundTruth();
+
+  const Stimuli on{{1, 2, true}};
+  const Stimuli both{{1, 2, false}, {1, 2, true}, {3, 0, false}};
+  const Stimuli off{{1, 2, false}, {3, 0, false}};
+  ASSERT_TRUE(efft.update(on));
+  ASSERT_FALSE(efft.update(both));
+  ASSERT_FALSE(efft.update(Stimulus{1, 2, true}));
+  ASSERT_TRUE(efft.update(off));
+  ASSERT_FALSE(efft.update(off));
+  ASSERT_FALSE(efft.update(Stimulus{3, 0, false}));
+  efft.updateGroundTruth(on);
+  efft.updateGroundTruth(off);
+  ASSERT_LT(efft.check(), 0.001);
+}
+TEST(eFFTTest, FeedWithRedundantPackets) {
+  FeedWithRedundantPackets<4>();
+  FeedWithRedundantPackets<16>();
+  FeedWithRedundantPackets<256>();
+}
+
+template <unsigned int FRAME_SIZE>
+static void InitializeWithImage() {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+
+  cfloatmat image(cfloatmat::Zero(FRAME_SIZE, FRAME_SIZE));
+  for(const Stimulus &s : rand.next(FRAME_SIZE * FRAME_SIZE / 4, true)) {
+    image(s.row, s.col) = 1;
+  }
+  efft.initialize(image);
+  efft.initializeGroundTruth(image);
+  ASSERT_LT(efft.check(), 0.1);
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimulus s = rand.next();
+    efft.update(s);
+    efft.updateGroundTruth(s);
+    ASSERT_LT(efft.check(), 0.1);
+  }
+
+  efft.initialize();
+  efft.initializeGroundTruth();
+  ASSERT_LT(efft.check(), 0.001);
+}
+TEST(eFFTTest, InitializeWithImage) {
+  InitializeWithImage<4>();
+  InitializeWithImage<8>();
+  InitializeWithImage<16>();
+  InitializeWithImage<32>();
+  InitializeWithImage<64>();
+  InitializeWithImage<128>();
+  InitializeWithImage<256>();
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedWithEventsDelta() {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.setPropagation(Propagation::Delta);
+
+  Stimulus s;
+  for(unsigned int test = 0; test < NTEST; test++) {
+    if(!test) {
+      efft.initialize();
+      efft.initializeGroundTruth();
+    } else if(test % 5 == 0) {
+      Stimuli ss = rand.next(10U);
+      efft.updateGroundTruth(ss);
+      efft.update(ss);
+    } else {
+      efft.update(s);
+      efft.updateGroundTruth(s);
+    }
+    ASSERT_LT(efft.check(), 0.01);
+    s = rand.next();
+  }
+}
+TEST(eFFTTest, FeedWithEventsDelta) {
+  FeedWithEventsDelta<4>();
+  FeedWithEventsDelta<8>();
+  FeedWithEventsDelta<16>();
+  FeedWithEventsDelta<32>();
+  FeedWithEventsDelta<64>();
+  FeedWithEventsDelta<128>();
+  FeedWithEventsDelta<256>();
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedWithConstPackets(const unsigned int PACKET_SIZE) {
+  eFFT<FRAME_SIZE> efft1;
+  eFFT<FRAME_SIZE> efft2;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft1.initialize();
+  efft2.initialize();
+  efft1.initializeGroundTruth();
+  efft2.initializeGroundTruth();
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimuli ss = rand.next(PACKET_SIZE);
+    const Stimuli copy = ss;
+    ASSERT_EQ(efft1.update(ss), efft2.update(ss.data(), ss.size()));
+    for(std::size_t i = 0; i < ss.size(); i++) {
+      ASSERT_EQ(ss[i], copy[i]);
+      ASSERT_EQ(ss[i].state, copy[i].state);
+    }
+    efft1.updateGroundTruth(ss);
+    efft2.updateGroundTruth(ss);
+    ASSERT_LT(efft1.check(), 0.1);
+    ASSERT_LT(efft2.check(), 0.1);
+  }
+}
+TEST_P(eFFTTest, FeedWithConstPackets) {
+  const unsigned int p = GetParam();
+  FeedWithConstPackets<4>(p);
+  FeedWithConstPackets<8>(p);
+  FeedWithConstPackets<16>(p);
+  FeedWithConstPackets<32>(p);
+  FeedWithConstPackets<64>(p);
+  FeedWithConstPackets<128>(p);
+  FeedWithConstPackets<256>(p);
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedWithDeduplicatedPackets(const unsigned int PACKET_SIZE) {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.setDeduplicate(true);
+  efft.initialize();
+  efft.initializeGroundTruth();
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimuli ss = rand.next(PACKET_SIZE);
+    efft.updateGroundTruth(ss);
+    efft.update(ss);
+    ASSERT_LT(efft.check(), 0.1);
+  }
+}
+TEST_P(eFFTTest, FeedWithDeduplicatedPackets) {
+  const unsigned int p = GetParam();
+  FeedWithDeduplicatedPackets<4>(p);
+  FeedWithDeduplicatedPackets<8>(p);
+  FeedWithDeduplicatedPackets<16>(p);
+  FeedWithDeduplicatedPackets<32>(p);
+  FeedWithDeduplicatedPackets<64>(p);
+  FeedWithDeduplicatedPackets<128>(p);
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedWithPacketsParallel(const unsigned int threads) {
+  eFFT<FRAME_SIZE> efft;
+  RandEventGenerator<FRAME_SIZE> rand;
+  efft.setThreads(threads, 3);
+  efft.setParallelCombine(16);
+  ASSERT_EQ(efft.threads(), threads);
+
+  cfloatmat image(cfloatmat::Zero(FRAME_SIZE, FRAME_SIZE));
+  for(const Stimulus &s : rand.next(FRAME_SIZE * FRAME_SIZE / 4, true)) {
+    image(s.row, s.col) = 1;
+  }
+  efft.initialize(image);
+  efft.initializeGroundTruth(image);
+  ASSERT_LT(efft.check(), 0.1);
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    Stimuli ss = rand.next(1000U);
+    efft.updateGroundTruth(ss);
+    efft.update(ss);
+    ASSERT_LT(efft.check(), 0.1);
+
+    const Stimulus s = rand.next();
+    efft.updateGroundTruth(s);
+    efft.update(s);
+    ASSERT_LT(efft.check(), 0.1);
+  }
+}
+TEST(eFFTTest, FeedWithPacketsParallel) {
+  for(const unsigned int threads : {2, 4}) {
+    FeedWithPacketsParallel<4>(threads);
+    FeedWithPacketsParallel<8>(threads);
+    FeedWithPacketsParallel<16>(threads);
+    FeedWithPacketsParallel<32>(threads);
+    FeedWithPacketsParallel<64>(threads);
+    FeedWithPacketsParallel<128>(threads);
+    FeedWithPacketsParallel<256>(threads);
+  }
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedLazily() {
+  eFFT<FRAME_SIZE> efft;
+  eFFT<FRAME_SIZE> lazy;
+  RandEventGenerator<FRAME_SIZE> rand;
+  lazy.setLazy(true);
+  efft.initialize();
+  lazy.initialize();
+  lazy.initializeGroundTruth();
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    for(unsigned int it = 0; it < 10; it++) {
+      const Stimulus s = rand.next();
+      ASSERT_EQ(lazy.update(s), efft.update(s));
+      lazy.updateGroundTruth(s);
+    }
+    Stimuli ss = rand.next(100U);
+    Stimuli aux = ss;
+    lazy.updateGroundTruth(ss);
+    ASSERT_EQ(lazy.update(ss), efft.update(aux));
+    ASSERT_LT(lazy.check(), 0.1);
+  }
+
+  const Stimulus s = rand.next(true);
+  ASSERT_EQ(lazy.update(s), efft.update(s));
+  lazy.setLazy(false);
+  ASSERT_LT((lazy.getFFT() - efft.getFFT()).norm(), 0.1F);
+}
+TEST(eFFTTest, FeedLazily) {
+  FeedLazily<4>();
+  FeedLazily<8>();
+  FeedLazily<16>();
+  FeedLazily<32>();
+  FeedLazily<64>();
+  FeedLazily<128>();
+  FeedLazily<256>();
+}
+
+template <unsigned int FRAME_SIZE>
+static void FeedHalfSpectrum(const Propagation propagation) {
+  eFFT<FRAME_SIZE, FRAME_SIZE, eFFTHalfSpectrumTraits> half;
+  eFFT<FRAME_SIZE> full;
+  RandEventGenerator<FRAME_SIZE> rand;
+  half.setPropagation(propagation);
+
+  cfloatmat image(cfloatmat::Zero(FRAME_SIZE, FRAME_SIZE));
+  for(const Stimulus &s : rand.next(FRAME_SIZE * FRAME_SIZE / 4, true)) {
+    image(s.row, s.col) = 1;
+  }
+  half.initialize(image);
+  half.initializeGroundTruth(image);
+  full.initialize(image);
+  ASSERT_EQ(half.getFFT().cols(), FRAME_SIZE / 2 + 1);
+  ASSERT_LT(half.check(), 0.1);
+  ASSERT_LE(half.footprint(), full.footprint());
+
+  for(unsigned int test = 0; test < NTEST; test++) {
+    const Stimulus s = rand.next();
+    ASSERT_EQ(half.update(s), full.update(s));
+    half.updateGroundTruth(s);
+    ASSERT_LT(half.check(), 0.1);
+
+    const Stimuli ss = rand.next(100U);
+    ASSERT_EQ(half.update(ss), full.update(ss));
+    half.updateGroundTruth(ss);
+    ASSERT_LT(half.check(), 0.1);
+  }
+  ASSERT_LT((half.getFullFFT() - half.getGroundTruthFFT()).norm(), 0.1);
+  ASSERT_LT((half.getFullFFT() - full.getFFT()).norm(), 0.1);
+}
+TEST(eFFTTest, FeedHalfSpectrum) {
+  for(const Propagation propagation : {Propagation::Tree, Propagation::Delta}) {
+    FeedHalfSpectrum<2>(propagation);
+    FeedHalfSpectrum<4>(propagation);
+    FeedHalfSpectrum<8>(propagation);
+    FeedHalfSpectrum<16>(propagation);
+    FeedHalfSpectrum<32>(propagation);
+    FeedHalfSpectrum<64>(propagation);
+    FeedHalfSpectrum<128>(propagation);
+    FeedHalfSpectrum<256>(propagation);
+  }
+}
+
+template <unsigned int WIDTH, unsigned int HEIGHT, typename Traits>
+static double FeedWithTraits() { // returns the largest error against the ground truth
+  eFFT<WIDTH, HEIGHT, Traits> efft;
+  eFFT<WIDTH, HEIGHT, Traits> lazy;
+  eFFT<WIDTH, HEIGHT, Traits> parallel;
+  RandEventGenerator<WIDTH> cols;
+  RandEventGenerator<HEIGHT> rows;
+  const auto next = [&cols, &rows] {
+    const Stimulus s = cols.next();
+    return Stimulus(rows.next().row, s.col, s.state);
+  };
+  lazy.setLazy(true);
+  parallel.setThreads(2, 2);
+  parallel.setParallelCombine(16);
+  EXPECT_EQ(efft.width(), WIDTH);
+  EXPECT_EQ(efft.height(), HEIGHT);
+
+  cfloatmat image(cfloatmat::Zero(HEIGHT, WIDTH));
+  for(unsigned int k = 0; k < WIDTH * HEIGHT / 4; k++) {
+    const Stimulus s = next();
+    image(s.row, s.col) = 1;
+  }
+  efft.initialize(image);
+  efft.initializeGroundTruth(image);
+  lazy.initialize(image);
+  parallel.initialize(image);
+
+  double error = efft.check();
+  for(unsigned int test = 0; test < NTEST; test++) {
+    efft.setPropagation(test % 2 ? Propagation::Delta : Propagation::Tree);
+    const Stimulus s = next();
+    EXPECT_EQ(efft.update(s), lazy.update(s));
+    parallel.update(s);
+    efft.updateGroundTruth(s);
+    error = std::max(error, efft.check());
+
+    Stimuli ss;
+    for(unsigned int k = 0; k < 100; k++) {
+      ss.push_back(next());
+    }
+    EXPECT_EQ(efft.update(ss), lazy.update(ss));
+    parallel.update(ss);
+    efft.updateGroundTruth(ss);
+    error = std::max(error, efft.check());
+  }
+  EXPECT_LT((lazy.getFFT() - efft.getFFT()).norm(), 0.1);
+  EXPECT_LT((parallel.getFFT() - efft.getFFT()).norm(), 0.1);
+  EXPECT_LT((efft.getFullFFT().template cast<cfloat>() - efft.getGroundTruthFFT()).norm(), 0.1 + 2 * error); // mirrored half spectra double the error
+  return error;
+}
+
+template <unsigned int B, bool HALF>
+struct BlockTraits : eFFTTraits {
+  static constexpr bool HALF_SPECTRUM = HALF;
+  static constexpr unsigned int LEAF_BLOCK = B;
+};
+
+template <unsigned int FRAME_SIZE, typename Traits>
+static void FeedBlocked() {
+  ASSERT_LT((FeedWithTraits<FRAME_SIZE, FRAME_SIZE, Traits>()), 0.1);
+}
+TEST(eFFTTest, FeedBlocked) {
+  FeedBlocked<4, BlockTraits<4, false>>();
+  FeedBlocked<8, BlockTraits<4, false>>();
+  FeedBlocked<64, BlockTraits<4, false>>();
+  FeedBlocked<256, BlockTraits<4, false>>();
+  FeedBlocked<8, BlockTraits<8, false>>();
+  FeedBlocked<16, BlockTraits<8, false>>();
+  FeedBlocked<64, BlockTraits<8, false>>();
+  FeedBlocked<256, BlockTraits<8, false>>();
+  FeedBlocked<4, BlockTraits<4, true>>();
+  FeedBlocked<64, BlockTraits<4, true>>();
+  FeedBlocked<8, BlockTraits<8, true>>();
+  FeedBlocked<256, BlockTraits<8, true>>();
+}
+
+template <unsigned int B>
+struct Radix4Traits : eFFTTraits {
+  static constexpr unsigned int LEAF_BLOCK = B;
+  static constexpr unsigned int RADIX = 4;
+};
+
+template <unsigned int FRAME_SIZE, typename Traits>
+static void FeedRadix4() {
+  ASSERT_LT((FeedWithTraits<FRAME_SIZE, FRAME_SIZE, Traits>()), 0.1);
+}
+TEST(eFFTTest, FeedRadix4) {
+  FeedRadix4<2, Radix4Traits<1>>();
+  FeedRadix4<4, Radix4Traits<1>>();
+  FeedRadix4<8, Radix4Traits<1>>();
+  FeedRadix4<16, Radix4Traits<1>>();
+  FeedRadix4<32, Radix4Traits<1>>();
+  FeedRadix4<64, Radix4Traits<1>>();
+  FeedRadix4<128, Radix4Traits<1>>();
+  FeedRadix4<256, Radix4Traits<1>>();
+  FeedRadix4<16, Radix4Traits<4>>();
+  FeedRadix4<128, Radix4Traits<4>>();
+  FeedRadix4<32, Radix4Traits<8>>();
+  FeedRadix4<256, Radix4Traits<8>>();
+}
+
+template <bool HALF, unsigned int COMPACT = 0>
+struct RectangularTraits : eFFTTraits {
+  static constexpr bool HALF_SPECTRUM = HALF;
+  static constexpr unsigned int COMPACT_LEVELS = COMPACT;
+};
+
+template <unsigned int WIDTH, unsigned int HEIGHT, typename Traits = eFFTTraits>
+static void FeedRectangular() {
+  ASSERT_LT((FeedWithTraits<WIDTH, HEIGHT, Traits>()), 0.1);
+}
+TEST(eFFTTest, FeedRectangular) {
+  FeedRectangular<2, 1>();
+  FeedRectangular<1, 4>();
+  FeedRectangular<4, 2>();
+  FeedRectangular<2, 8>();
+  FeedRectangular<16, 4>();
+  FeedRectangular<8, 64>();
+  FeedRectangular<64, 16>();
+  FeedRectangular<256, 32>();
+  FeedRectangular<32, 128>();
+  FeedRectangular<2, 1, RectangularTraits<true>>();
+  FeedRectangular<4, 2, RectangularTraits<true>>();
+  FeedRectangular<2, 8, RectangularTraits<true>>();
+  FeedRectangular<16, 4, RectangularTraits<true>>();
+  FeedRectangular<8, 64, RectangularTraits<true>>();
+  FeedRectangular<64, 16, RectangularTraits<true>>();
+  FeedRectangular<256, 32, RectangularTraits<true>>();
+  FeedRectangular<32, 128, RectangularTraits<true>>();
+  FeedRectangular<128, 64, RectangularTraits<false, 3>>();
+  FeedRectangular<64, 128, RectangularTraits<true, 3>>();
+}
+
+template <typename S, unsigned int COMPACT = 0, typename C = bfloat16, unsigned int B = 1, bool HALF = false>
+struct PrecisionTraits : eFFTTraits {
+  static constexpr bool HALF_SPECTRUM = HALF;
+  static constexpr unsigned int LEAF_BLOCK = B;
+  using Scalar = S;
+  using Compact = C;
+  static constexpr unsigned int COMPACT_LEVELS = COMPACT;
+};
+
+template <unsigned int FRAME_SIZE, typename Traits>
+static double FeedPrecision() {
+  return FeedWithTraits<FRAME_SIZE, FRAME_SIZE, Traits>() / (FRAME_SIZE * FRAME_SIZE); // relative to N², about the norm of the spectrum of a half-full frame
+}
+TEST(eFFTTest, FeedPrecision) {
+  ASSERT_LT((FeedPrecision<64, PrecisionTraits<double>>()), 1e-12);
+  ASSERT_LT((FeedPrecision<256, PrecisionTraits<double>>()), 1e-12);
+  ASSERT_LT((FeedPrecision<64, PrecisionTraits<float>>()), 1e-6);
+  ASSERT_LT((FeedPrecision<256, PrecisionTraits<float>>()), 1e-6);
+  ASSERT_LT((FeedPrecision<64, PrecisionTraits<float, 4>>()), 1e-2);
+  ASSERT_LT((FeedPrecision<256, PrecisionTraits<float, 6>>()), 1e-2);
+  ASSERT_LT((FeedPrecision<64, PrecisionTraits<float, 4, float16>>()), 1e-3);
+  ASSERT_LT((FeedPrecision<256, PrecisionTraits<float, 8, float16>>()), 1e-3);
+  ASSERT_LT((FeedPrecision<256, PrecisionTraits<double, 4, float16>>()), 1e-3);
+  ASSERT_LT((FeedPrecision<128, PrecisionTraits<float, 4, bfloat16, 4>>()), 1e-2);
+  ASSERT_LT((FeedPrecision<128, PrecisionTraits<float, 4, float16, 8, true>>()), 1e-3);
+  ASSERT_LT((FeedPrecision<128, PrecisionTraits<double, 4, bfloat16, 1, true>>()), 1e-2);
+}
+
 INSTANTIATE_TEST_CASE_P(eFFTWithPackets, eFFTTest, ::testing::Values(1, 10, 100, 1000, 10000));
 #endif